@@ -0,0 +1,179 @@
+#include <algorithm>
+
+#include "TObjArray.h"
+#include "TSystem.h"
+#include "TTree.h"
+
+#include "LUtils/Debugging.hxx"
+
+#include "MemoryBudget.hxx"
+
+namespace {
+const Long64_t kMB = 1024 * 1024;
+///Smallest input cache that is still worth having.
+const Long64_t kMinInputCache = 1 * kMB;
+///Largest input cache, beyond this there is no gain for sequential reads.
+const Long64_t kMaxInputCache = 256 * kMB;
+///Smallest auto-flush cluster size the plan will shrink to.
+const Long64_t kMinAutoFlush = 1 * kMB;
+const Int_t kMinBasketSize = 4000;
+const Int_t kMaxBasketSize = 256000;
+///Fraction of the budget above which the monitor starts to shrink the plan.
+const double kHighWaterFraction = 0.9;
+
+double ToMB(Long64_t bytes) { return double(bytes) / double(kMB); }
+
+Int_t BasketSizeFor(Long64_t AutoFlush, Int_t NOutputLeaves) {
+  Long64_t bs = AutoFlush / std::max(NOutputLeaves, 1);
+  return Int_t(std::min(std::max(bs, Long64_t(kMinBasketSize)),
+                        Long64_t(kMaxBasketSize)));
+}
+}
+
+namespace MemoryBudget {
+
+Plan::Plan()
+    : Budget(0),
+      Baseline(0),
+      InputCache(0),
+      EventBuffers(0),
+      OutputBaskets(0),
+      AutoFlush(0),
+      BasketSize(0) {}
+
+Plan MakePlan(Long64_t Budget, Long64_t Baseline, Long64_t EventBuffers) {
+  Plan plan;
+  plan.Budget = Budget;
+  plan.Baseline = Baseline;
+  plan.EventBuffers = EventBuffers;
+
+  Long64_t Remaining = Budget - Baseline - EventBuffers;
+  if (Remaining < (kMinInputCache + 2 * kMinAutoFlush)) {
+    UDBWarn("Memory budget of "
+            << ToMB(Budget) << " MB leaves only " << ToMB(Remaining)
+            << " MB after the baseline (" << ToMB(Baseline)
+            << " MB) and event buffers (" << ToMB(EventBuffers)
+            << " MB). Falling back to minimum buffer sizes.");
+    Remaining = kMinInputCache + 2 * kMinAutoFlush;
+  }
+
+  plan.InputCache = std::min(std::max(Long64_t(0.3 * Remaining),
+                                      kMinInputCache),
+                             kMaxInputCache);
+  plan.OutputBaskets = Remaining - plan.InputCache;
+  plan.AutoFlush = std::max(plan.OutputBaskets / 2, kMinAutoFlush);
+  plan.BasketSize = kMaxBasketSize;
+  return plan;
+}
+
+Long64_t GetCurrentRSS() {
+  ProcInfo_t pinfo;
+  if (gSystem->GetProcInfo(&pinfo)) {
+    return 0;
+  }
+  return Long64_t(pinfo.fMemResident) * 1024;
+}
+
+Monitor::Monitor(Plan const& plan, TTree* InputTree)
+    : fInputTree(InputTree),
+      fPlan(plan),
+      fInitialPlan(plan),
+      fPeakRSS(GetCurrentRSS()),
+      fHighWater(Long64_t(kHighWaterFraction * plan.Budget)),
+      fNEarlyFlushes(0),
+      fNShrinks(0),
+      fWarnedTreeCount(false) {
+  Apply();
+}
+
+void Monitor::AddOutputTree(TTree* OutputTree) {
+  fOutputTrees.push_back(OutputTree);
+  Apply();
+  if (fNShrinks == 0) {
+    fInitialPlan = fPlan;
+  }
+}
+
+void Monitor::Apply() {
+  if (fInputTree) {
+    fInputTree->SetCacheSize(fPlan.InputCache);
+  }
+  if (fOutputTrees.empty()) {
+    return;
+  }
+
+  Int_t NOutputLeaves = 0;
+  for (TTree* OutputTree : fOutputTrees) {
+    NOutputLeaves += OutputTree->GetListOfLeaves()->GetEntries();
+  }
+  fPlan.BasketSize = BasketSizeFor(fPlan.AutoFlush, NOutputLeaves);
+
+  Long64_t NOutputTrees = Long64_t(fOutputTrees.size());
+  if ((!fWarnedTreeCount) &&
+      ((NOutputTrees * kMinAutoFlush) > fPlan.AutoFlush)) {
+    UDBWarn("The " << NOutputTrees << " output trees need at least "
+                   << ToMB(NOutputTrees * kMinAutoFlush)
+                   << " MB of auto-flush between them, more than the "
+                   << ToMB(fPlan.AutoFlush)
+                   << " MB planned. The output baskets will not fit in the "
+                      "memory budget, use a larger budget or fewer outputs.");
+    fWarnedTreeCount = true;
+  }
+  Long64_t TreeAutoFlush =
+      std::max(fPlan.AutoFlush / NOutputTrees, kMinAutoFlush);
+  for (TTree* OutputTree : fOutputTrees) {
+    // Negative values are interpreted as a number of bytes.
+    OutputTree->SetAutoFlush(-TreeAutoFlush);
+    OutputTree->SetBasketSize("*", fPlan.BasketSize);
+  }
+}
+
+void Monitor::Check() {
+  Long64_t RSS = GetCurrentRSS();
+  fPeakRSS = std::max(fPeakRSS, RSS);
+  if (RSS < fHighWater) {
+    return;
+  }
+
+  for (TTree* OutputTree : fOutputTrees) {
+    OutputTree->FlushBaskets();
+  }
+  fNEarlyFlushes++;
+
+  if ((fPlan.AutoFlush <= kMinAutoFlush) &&
+      (fPlan.InputCache <= kMinInputCache)) {
+    return;
+  }
+
+  fPlan.AutoFlush = std::max(fPlan.AutoFlush / 2, kMinAutoFlush);
+  fPlan.OutputBaskets = 2 * fPlan.AutoFlush;
+  fPlan.InputCache = std::max(fPlan.InputCache / 2, kMinInputCache);
+  fNShrinks++;
+
+  UDBWarn("Resident memory (" << ToMB(RSS) << " MB) is close to the budget ("
+                              << ToMB(fPlan.Budget)
+                              << " MB). Shrinking auto-flush to "
+                              << ToMB(fPlan.AutoFlush) << " MB and the input "
+                                                          "cache to "
+                              << ToMB(fPlan.InputCache) << " MB.");
+  Apply();
+}
+
+void Monitor::Report() const {
+  UDBLog("Memory budget report (MB):"
+         << "\n\tBudget          : " << ToMB(fPlan.Budget)
+         << "\n\tBaseline        : " << ToMB(fPlan.Baseline)
+         << "\n\tInput cache     : " << ToMB(fInitialPlan.InputCache)
+         << " planned, " << ToMB(fPlan.InputCache) << " final"
+         << "\n\tEvent buffers   : " << ToMB(fPlan.EventBuffers)
+         << "\n\tOutput baskets  : " << ToMB(fInitialPlan.OutputBaskets)
+         << " planned (" << ToMB(fInitialPlan.AutoFlush) << " auto-flush, "
+         << fInitialPlan.BasketSize << " B baskets), "
+         << ToMB(fPlan.OutputBaskets) << " final ("
+         << ToMB(fPlan.AutoFlush) << " auto-flush, " << fPlan.BasketSize
+         << " B baskets)"
+         << "\n\tPeak RSS        : " << ToMB(fPeakRSS)
+         << "\n\tEarly flushes   : " << fNEarlyFlushes
+         << "\n\tPlan shrinks    : " << fNShrinks);
+}
+}
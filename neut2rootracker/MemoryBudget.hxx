@@ -0,0 +1,91 @@
+#ifndef MEMORYBUDGET_HXX_SEEN
+#define MEMORYBUDGET_HXX_SEEN
+#include <vector>
+
+#include "Rtypes.h"
+
+class TTree;
+
+///\brief Tools for keeping a conversion job under a fixed memory budget.
+///
+///\details The main consumers of memory in a conversion are the input
+/// \c TTreeCache, the input and output event buffers and the output basket
+/// buffers, which are held until each auto-flush cluster is written.
+namespace MemoryBudget {
+
+///Describes how a memory budget has been split between consumers. All sizes
+///are in bytes.
+struct Plan {
+  Plan();
+  ///The total allowed resident set size.
+  Long64_t Budget;
+  ///The resident set size before any conversion buffers were allocated.
+  ///Accounts for ROOT, the dictionaries and the loaded libraries.
+  Long64_t Baseline;
+  ///Size of the input \c TTreeCache.
+  Long64_t InputCache;
+  ///Size of the input and output event buffers.
+  Long64_t EventBuffers;
+  ///Memory reserved for the output baskets (and their compression buffers).
+  Long64_t OutputBaskets;
+  ///Number of output bytes to accumulate before each auto-flush.
+  Long64_t AutoFlush;
+  ///Per-branch output basket size.
+  Int_t BasketSize;
+};
+
+///\brief Splits a budget between the input cache and the output baskets.
+///
+///\details Whatever is left after the baseline and the event buffers is split
+/// 30/70 between the input cache and the output baskets. The output share
+/// is halved for the auto-flush size, as each basket is held alongside its
+/// compression buffer when a cluster is flushed.
+Plan MakePlan(Long64_t Budget, Long64_t Baseline, Long64_t EventBuffers);
+
+///Returns the current resident set size of this process in bytes.
+Long64_t GetCurrentRSS();
+
+///\brief Applies a plan to the input and output trees, tracks the peak
+/// resident set size while converting and shrinks the plan when the process
+/// gets close to the budget.
+class Monitor {
+public:
+  ///Sets the planned input cache size on \c InputTree, which may be
+  ///\c nullptr.
+  Monitor(Plan const& plan, TTree* InputTree);
+  ///\brief Adds an output tree to the plan.
+  ///
+  ///\details The auto-flush size is shared equally between all of the output
+  /// trees, and the basket size between all of their leaves, so this
+  /// re-applies the plan to every output tree added so far. Each tree keeps
+  /// an auto-flush size of at least 1 MB, so a warning is written once when
+  /// there are too many output trees to fit in the planned output baskets.
+  void AddOutputTree(TTree* OutputTree);
+  ///\brief Samples the resident set size.
+  ///
+  ///\details If it is above the high-water mark the output baskets are
+  /// flushed early and the auto-flush, basket and input cache sizes are
+  /// halved and re-applied.
+  void Check();
+  ///Writes the planned and final memory split to the log.
+  void Report() const;
+
+  Plan const& GetPlan() const { return fPlan; }
+  Long64_t GetPeakRSS() const { return fPeakRSS; }
+
+private:
+  ///Sets the current plan on the input and output trees.
+  void Apply();
+
+  TTree* fInputTree;
+  std::vector<TTree*> fOutputTrees;
+  Plan fPlan;
+  Plan fInitialPlan;
+  Long64_t fPeakRSS;
+  Long64_t fHighWater;
+  Int_t fNEarlyFlushes;
+  Int_t fNShrinks;
+  bool fWarnedTreeCount;
+};
+}
+#endif
@@ -0,0 +1,178 @@
+#include <sstream>
+#include <vector>
+
+#include "TLorentzVector.h"
+
+#include "neutvect.h"
+#include "neutvtx.h"
+
+#include "neutfsipart.h"
+#include "neutfsivert.h"
+
+#include "LUtils/Debugging.hxx"
+
+#include "NeutStream.hxx"
+
+namespace {
+///Checks that all fields of a record were read, and that there are no more.
+bool ReadAll(std::istringstream& ss) {
+  if (ss.fail()) {
+    return false;
+  }
+  std::string extra;
+  return !(ss >> extra);
+}
+}
+
+namespace NeutStream {
+
+FileInfo::FileInfo() : NEntries(0), FluxIntegral(0), EvtRateIntegral(0) {}
+
+Reader::Reader(std::istream& in, std::string const& Name)
+    : fIn(in),
+      fName(Name),
+      fLineNumber(0),
+      fFileNumber(0),
+      fNEventsInFile(0) {}
+
+bool Reader::NextLine() {
+  while (std::getline(fIn, fLine)) {
+    fLineNumber++;
+    size_t first = fLine.find_first_not_of(" \t\r");
+    if ((first == std::string::npos) || (fLine[first] == '#')) {
+      continue;
+    }
+    return true;
+  }
+  return false;
+}
+
+Reader::Status Reader::Next(NeutVect* vector, NeutVtx* vtx) {
+  std::vector<NeutPart> Parts;
+  std::vector<NeutFsiVert> FsiVerts;
+  std::vector<NeutFsiPart> FsiParts;
+  TLorentzVector VtxPos;
+  VtxPos.SetXYZT(0, 0, 0, 0);
+  Int_t Nprimary = 0;
+  bool InEvent = false;
+
+  while (NextLine()) {
+    std::istringstream ss(fLine);
+    std::string Record;
+    ss >> Record;
+
+    bool Parsed = false;
+    if (!InEvent) {
+      if (Record == "FILE") {
+        FileInfo info;
+        ss >> info.NEntries >> info.FluxIntegral >> info.EvtRateIntegral;
+        if ((Parsed = ReadAll(ss))) {
+          if (fNEventsInFile) {
+            fFileNumber++;
+            fNEventsInFile = 0;
+          }
+          fFileInfo = info;
+          continue;
+        }
+      } else if (Record == "EVENT") {
+        ss >> vector->EventNo >> vector->Mode >> vector->TargetA >>
+            vector->TargetZ >> vector->TargetH >> vector->Ibound >>
+            vector->Totcrs >> Nprimary;
+        vector->Crsx = 0;
+        vector->Crsy = 0;
+        vector->Crsz = 0;
+        vector->Crsphi = 0;
+        InEvent = Parsed = ReadAll(ss);
+      } else {
+        UDBError(fName << ":" << fLineNumber << ": Expected an EVENT or FILE "
+                                                "record, found: \""
+                       << fLine << "\"");
+        return kError;
+      }
+    } else if (Record == "CRS") {
+      ss >> vector->Crsx >> vector->Crsy >> vector->Crsz >> vector->Crsphi;
+      Parsed = ReadAll(ss);
+    } else if (Record == "PART") {
+      NeutPart part;
+      Int_t IsAlive;
+      Double_t Px, Py, Pz, E;
+      ss >> part.fPID >> part.fStatus >> IsAlive >> part.fMass >> Px >> Py >>
+          Pz >> E;
+      if ((Parsed = ReadAll(ss))) {
+        part.fIsAlive = IsAlive;
+        part.fP.SetPxPyPzE(Px, Py, Pz, E);
+        part.fPosIni.SetXYZT(0, 0, 0, 0);
+        part.fPosFin.SetXYZT(0, 0, 0, 0);
+        Parts.push_back(part);
+      }
+    } else if (Record == "FSIVERT") {
+      NeutFsiVert vert;
+      Double_t X, Y, Z;
+      ss >> vert.fVertID >> X >> Y >> Z;
+      if ((Parsed = ReadAll(ss))) {
+        vert.fPos.SetXYZ(X, Y, Z);
+        FsiVerts.push_back(vert);
+      }
+    } else if (Record == "FSIPART") {
+      NeutFsiPart part;
+      Double_t DirX, DirY, DirZ;
+      ss >> part.fPID >> DirX >> DirY >> DirZ >> part.fMomLab >>
+          part.fMomNuc >> part.fVertStart >> part.fVertEnd;
+      if ((Parsed = ReadAll(ss))) {
+        part.fDir.SetXYZ(DirX, DirY, DirZ);
+        FsiParts.push_back(part);
+      }
+    } else if (Record == "VTX") {
+      Double_t X, Y, Z, T;
+      ss >> X >> Y >> Z >> T;
+      if ((Parsed = ReadAll(ss))) {
+        VtxPos.SetXYZT(X, Y, Z, T);
+      }
+    } else if (Record == "END") {
+      if (!ReadAll(ss)) {
+        UDBError(fName << ":" << fLineNumber << ": Malformed END record: \""
+                       << fLine << "\"");
+        return kError;
+      }
+      vector->SetNpart(Parts.size());
+      vector->SetNprimary(Nprimary);
+      for (size_t i = 0; i < Parts.size(); ++i) {
+        vector->SetPartInfo(i, Parts[i]);
+      }
+      vector->SetNfsiVert(FsiVerts.size());
+      for (size_t i = 0; i < FsiVerts.size(); ++i) {
+        vector->SetFsiVertInfo(i, FsiVerts[i]);
+      }
+      vector->SetNfsiPart(FsiParts.size());
+      for (size_t i = 0; i < FsiParts.size(); ++i) {
+        vector->SetFsiPartInfo(i, FsiParts[i]);
+      }
+#ifdef HAVE_NUCLEON_FSI_TRACKING
+      vector->SetNnucFsiVert(0);
+      vector->SetNnucFsiStep(0);
+#endif
+      vtx->SetNvtx(1);
+      vtx->SetPos(0, VtxPos);
+      fNEventsInFile++;
+      return kEvent;
+    } else {
+      UDBError(fName << ":" << fLineNumber << ": Unknown record: \"" << fLine
+                     << "\"");
+      return kError;
+    }
+
+    if (!Parsed) {
+      UDBError(fName << ":" << fLineNumber << ": Malformed " << Record
+                     << " record: \"" << fLine << "\"");
+      return kError;
+    }
+  }
+
+  if (InEvent) {
+    UDBError(fName << ": Stream ended part way through event "
+                   << vector->EventNo << ".");
+    return kError;
+  }
+  return kEnd;
+}
+}
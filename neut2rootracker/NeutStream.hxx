@@ -0,0 +1,79 @@
+#ifndef NEUTSTREAM_HXX_SEEN
+#define NEUTSTREAM_HXX_SEEN
+#include <istream>
+#include <string>
+
+#include "Rtypes.h"
+
+class NeutVect;
+class NeutVtx;
+
+///\brief Reads NEUT events from a line based text stream, so that events can
+/// be converted as they are generated, without an intermediate neutroot file.
+///
+///\details Each record is a single line of whitespace separated fields, lines
+/// starting with \c # and empty lines are skipped. Energies are in MeV and
+/// positions are in the NEUT native units, as in the neutroot files.
+///
+/// An event is written as:
+///\code
+/// EVENT <EventNo> <Mode> <TargetA> <TargetZ> <TargetH> <Ibound> <Totcrs> <Nprimary>
+/// CRS <Crsx> <Crsy> <Crsz> <Crsphi>
+/// PART <PID> <Status> <IsAlive> <Mass> <Px> <Py> <Pz> <E>
+/// FSIVERT <VertID> <X> <Y> <Z>
+/// FSIPART <PID> <DirX> <DirY> <DirZ> <MomLab> <MomNuc> <VertStart> <VertEnd>
+/// VTX <X> <Y> <Z> <T>
+/// END
+///\endcode
+/// with one \c PART record per particle, in the NEUT order, and any number of
+/// pion FSI history \c FSIVERT and \c FSIPART records. The \c CRS, \c FSIVERT,
+/// \c FSIPART and \c VTX records are optional, without a \c VTX record the
+/// vertex is at the origin.
+///
+/// A \c FILE record, <tt>FILE <NEntries> <FluxIntegral> <EvtRateIntegral></tt>,
+/// may be written between events to give the constants that would usually be
+/// taken from the neutroot file, so that the event weights can be calculated.
+/// A \c FILE record after the first event starts a new input file.
+namespace NeutStream {
+
+///The per input file constants given by a \c FILE record.
+struct FileInfo {
+  FileInfo();
+  ///Number of events in this file, or 0 if unknown.
+  Long64_t NEntries;
+  Double_t FluxIntegral;
+  Double_t EvtRateIntegral;
+};
+
+class Reader {
+public:
+  enum Status { kEvent, kEnd, kError };
+
+  ///\c Name is only used in messages.
+  Reader(std::istream& in, std::string const& Name);
+  ///\brief Reads the next event into \c vector and \c vtx.
+  ///
+  ///\details Returns \c kEnd at the end of the stream and writes an error and
+  /// returns \c kError for malformed records.
+  Status Next(NeutVect* vector, NeutVtx* vtx);
+
+  std::string const& GetName() const { return fName; }
+  ///The index of the current input file, incremented by each \c FILE record
+  ///after the first event.
+  Int_t GetFileNumber() const { return fFileNumber; }
+  FileInfo const& GetFileInfo() const { return fFileInfo; }
+
+private:
+  ///Reads the next non-empty, non-comment line into \c fLine.
+  bool NextLine();
+
+  std::istream& fIn;
+  std::string fName;
+  std::string fLine;
+  long fLineNumber;
+  Int_t fFileNumber;
+  long fNEventsInFile;
+  FileInfo fFileInfo;
+};
+}
+#endif
@@ -1,9 +1,23 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <mutex>
 #include <sstream>
+#include <thread>
+
+#include <unistd.h>
 
 #include "TChain.h"
+#include "TEntryList.h"
 #include "TFile.h"
 #include "TH1D.h"
+#include "TROOT.h"
+#include "TRandom3.h"
+#include "TStopwatch.h"
 #include "TTree.h"
 
 #include "neutvect.h"
@@ -23,16 +37,133 @@
 #include "LUtils/Debugging.hxx"
 #include "LUtils/Utils.hxx"
 
+#include "MemoryBudget.hxx"
+#include "NeutStream.hxx"
 #include "PureNeutRooTracker.hxx"
+#include "TopologySkim.hxx"
 
 namespace {
 
+///\brief Returns the number of seconds since this process was started, or -1
+/// if it is not known.
+///
+///\details Read from the process start time in <tt>/proc/self/stat</tt>, so
+/// that the dynamic loading and static initialisation of the linked libraries
+/// is included. The resolution is one clock tick.
+double GetSecondsSinceProcessStart() {
+  std::ifstream stat("/proc/self/stat");
+  std::ifstream uptime("/proc/uptime");
+  std::string line;
+  double UpTime;
+  if ((!std::getline(stat, line)) || (!(uptime >> UpTime))) {
+    return -1;
+  }
+  // The command name field may contain spaces, the fields after it don't.
+  size_t CommEnd = line.rfind(')');
+  if (CommEnd == std::string::npos) {
+    return -1;
+  }
+  std::istringstream ss(line.substr(CommEnd + 1));
+  std::string field;
+  // starttime is field 22, the command name is field 2.
+  for (int i = 3; i < 22; ++i) {
+    ss >> field;
+  }
+  unsigned long long StartTicks;
+  long TicksPerSecond = sysconf(_SC_CLK_TCK);
+  if ((!(ss >> StartTicks)) || (TicksPerSecond <= 0)) {
+    return -1;
+  }
+  return UpTime - (double(StartTicks) / double(TicksPerSecond));
+}
+
+///Returns the current wall clock time in seconds since the epoch.
+double GetWallClockTime() {
+  return std::chrono::duration<double>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+///Set by the first conversion to finish an event.
+std::atomic<bool> FirstEventTimed(false);
+
 std::ostream& operator<<(std::ostream& o, const TLorentzVector& tlv) {
   return o << "[" << tlv.X() << ", " << tlv.Y() << ", " << tlv.Z() << ", "
            << tlv.T() << "]";
 }
+
+///Inserts \c tag before the \c .root extension of \c FName.
+std::string AddFNameTag(std::string const& FName, std::string const& tag) {
+  size_t ext = FName.rfind(".root");
+  if ((ext == std::string::npos) || (ext != (FName.length() - 5))) {
+    return FName + "." + tag;
+  }
+  return FName.substr(0, ext) + "." + tag + ".root";
+}
 }
 
+/// Output options that can be set independently for each output file.
+struct SinkOpts {
+  SinkOpts()
+      : ObjectOutput(false),
+        OutputInGev(false),
+        SaveIsBound(false),
+        LiteMode(false),
+        SkipNonFS(false),
+        EmulateNuWro(false) {}
+  ///\brief Sets the flags from a string of short CLI option letters.
+  ///
+  ///\details Understands \c O, \c G, \c b, \c L, \c E and \c S, which have
+  /// the same meaning as the corresponding CLI options, e.g. \c "LE" for a
+  /// Lite mode, NuWro emulating output. Returns false for unknown letters.
+  bool SetFlags(std::string const& flags) {
+    for (char const& f : flags) {
+      switch (f) {
+        case 'O': {
+          ObjectOutput = true;
+          break;
+        }
+        case 'G': {
+          OutputInGev = true;
+          break;
+        }
+        case 'b': {
+          SaveIsBound = true;
+          break;
+        }
+        case 'L': {
+          LiteMode = true;
+          break;
+        }
+        case 'E': {
+          EmulateNuWro = true;
+          break;
+        }
+        case 'S': {
+          SkipNonFS = true;
+          break;
+        }
+        default: { return false; }
+      }
+    }
+    return true;
+  }
+  ///See NeutToRooTrackerOpts::OutFName.
+  std::string OutFName;
+  ///See NeutToRooTrackerOpts::ObjectOutput.
+  bool ObjectOutput;
+  ///See NeutToRooTrackerOpts::OutputInGev.
+  bool OutputInGev;
+  ///See NeutToRooTrackerOpts::SaveIsBound.
+  bool SaveIsBound;
+  ///See NeutToRooTrackerOpts::LiteMode.
+  bool LiteMode;
+  ///See NeutToRooTrackerOpts::SkipNonFS.
+  bool SkipNonFS;
+  ///See NeutToRooTrackerOpts::EmulateNuWro.
+  bool EmulateNuWro;
+};
+
 /// Contains the variables affected by the CLI options.
 namespace NeutToRooTrackerOpts {
 ///\brief The name to write the output \c TFile to.
@@ -99,109 +230,1229 @@ long MaxEntries = 0;
 ///\details Modes to ignore are added via like
 /// <tt>NeutToRooTracker.exe  -I 1,2,27</tt>.
 std::vector<int> ModeIgnores;
+///\brief Resident memory budget for the conversion in MB.
+///
+///\details When set, the input cache, output basket and auto-flush sizes are
+/// planned to fit in the budget, and are shrunk if the resident memory gets
+/// close to it during the conversion. Settable with the \c -M CLI option.
+long MaxMemoryMB = 0;
+///\brief Output tree layout options.
+///
+///\details The storage precision of the \c StdHepP4, \c StdHepX4 and
+/// \c StdHepPolz branch groups is set with the \c -P CLI option. Per-file
+/// metadata is enabled with the \c -F CLI option and the compact NEUT VCWork
+/// block with the \c -C CLI option.
+NRooTrackerSchema Schema;
+///\brief Additional output files to convert each input event into.
+///
+///\details Each output has its own flags, so that several flavors of output
+/// can be written from a single pass over the input. Added with the \c -X CLI
+/// option.
+std::vector<SinkOpts> ExtraSinks;
+///\brief Only events passing one of these final state topology predicates are
+/// written.
+///
+///\details Parsed once from the \c -T CLI option and evaluated on the
+/// converted StdHep arrays of each output just before it is filled.
+TopologySkim::Skim Skim;
+///\brief A file listing many conversions to run in a single process.
+///
+///\details Set with the \c -J CLI option, see ReadManifest.
+std::string ManifestFName;
+///\brief The number of worker threads to run manifest jobs on.
+///
+///\details Set with the \c -j CLI option, defaults to the number of cores.
+int NManifestWorkers = 0;
+///\brief A file listing the input files and events within them to convert.
+///
+///\details Set with the \c -e CLI option, see ReadEventList. Only the listed
+/// files are opened and only the listed entries are read.
+std::string EventListFName;
+///\brief Whether to write each interaction mode group to its own output file.
+///
+///\details Enabled with the \c -m CLI option. The group name is inserted
+/// before the \c .root extension of each output file name.
+bool SplitByMode = false;
+///\brief The group name for each NEUT mode when splitting by mode.
+///
+///\details If empty, each mode gets its own group named like \c mode11.
+/// Otherwise modes without a group are written to the \c other group.
+std::map<int, std::string> ModeGroups;
+///\brief Whether the FSI history friend tree is written to its own file.
+///
+///\details The FSI history is moved out of the main tree with the \c -H CLI
+/// option, which also chooses whether it goes to the same output file or to
+/// one named like \c vector.ntrac.fsi.root.
+bool FSIFriendSeparateFile = false;
+///\brief Converts only every \c SampleEvery'th entry of the input chain.
+///
+///\details Set with the \c -p CLI option. 0 means no prescale.
+long SampleEvery = 0;
+///\brief Converts a random sample of this fraction of the input entries.
+///
+///\details Set with the \c -p CLI option. Only used if \c SampleEvery is 0
+/// and this is greater than 0.
+double SampleFraction = 0;
+///The seed for the random sample, so that it is reproducible.
+UInt_t SampleSeed = 4357;
+///\brief Whether to log the time to the first converted event.
+///
+///\details Set with the \c -t CLI option, used by bench/StartupBench.sh.
+bool TimeFirstEvent = false;
+
+/// Returns the name of the output group that events of a NEUT mode belong to.
+std::string GetModeGroup(int Mode) {
+  if (!SplitByMode) {
+    return "";
+  }
+  if (ModeGroups.empty()) {
+    std::stringstream ss("");
+    ss << "mode" << Mode;
+    return ss.str();
+  }
+  std::map<int, std::string>::const_iterator grp = ModeGroups.find(Mode);
+  return (grp == ModeGroups.end()) ? "other" : grp->second;
+}
+
+/// Returns the output options for the file passed with the \c -o CLI option.
+SinkOpts GetMainSinkOpts() {
+  SinkOpts opts;
+  opts.OutFName = OutFName;
+  opts.ObjectOutput = ObjectOutput;
+  opts.OutputInGev = OutputInGev;
+  opts.SaveIsBound = SaveIsBound;
+  opts.LiteMode = LiteMode;
+  opts.SkipNonFS = SkipNonFS;
+  opts.EmulateNuWro = EmulateNuWro;
+  return opts;
 }
+}
+
+/// Converts a single NEUT event into the output buffers of a sink.
+void ConvertEvent(SinkOpts const& opts, NeutVect* vector, NeutVtx* vtx,
+                  NRooTrackerFileMeta const& file, long entryNum,
+                  NRooTrackerVtxB* outRooTracker,
+                  NRooTrackerVtx* FullRooTracker) {
+  float EUnitScaleFactor = 1.0;
+  if (opts.OutputInGev) {
+    EUnitScaleFactor = 1.0 / 1000;
+  }
+
+  //**************************************************
+  // Event Level
+  std::stringstream ss("");
+  ss << vector->Mode;
+  outRooTracker->EvtCode->SetString(ss.str().c_str());
+  outRooTracker->EvtNum = vector->EventNo;
+  outRooTracker->FileIndex = file.FileIndex;
+
+  if (!opts.LiteMode) {
+    FullRooTracker->EvtXSec = vector->Totcrs;
+    FullRooTracker->EvtWght = file.EvtWght;
+    FullRooTracker->EvtHistWght = file.EvtHistWght;
+    FullRooTracker->NEntriesInFile = file.NEntriesInFile;
+
+    FullRooTracker->NEcrsx = vector->Crsx;
+    FullRooTracker->NEcrsy = vector->Crsy;
+    FullRooTracker->NEcrsz = vector->Crsz;
+    FullRooTracker->NEcrsphi = vector->Crsphi;
+
+    if (vtx->Nvtx() != 1) {
+      UDBWarn("Vertex entry " << entryNum << " had " << vtx->Nvtx()
+                              << " entries, expected 1.");
+      FullRooTracker->EvtVtx[0] = 0.0;
+      FullRooTracker->EvtVtx[1] = 0.0;
+      FullRooTracker->EvtVtx[2] = 0.0;
+      FullRooTracker->EvtVtx[3] = 0.0;
+    } else {
+      FullRooTracker->EvtVtx[0] = vtx->Pos(0)->X();
+      FullRooTracker->EvtVtx[1] = vtx->Pos(0)->Y();
+      FullRooTracker->EvtVtx[2] = vtx->Pos(0)->Z();
+      FullRooTracker->EvtVtx[3] = vtx->Pos(0)->T();
+    }
+  }
+
+  //**************************************************
+  // StdHepN Particles
+
+  outRooTracker->IsBound = vector->Ibound;
+
+  int saveInd = 0;
+  for (int partNum = 0; partNum < vector->Npart(); ++partNum) {
+    const NeutPart& part = (*vector->PartInfo(partNum));
+
+    if (!opts.LiteMode) {
+      // Not saved unless we get to the end of this iteration
+      FullRooTracker->NEstdhepvc[partNum] = -1;
+    }
+
+    if ((partNum == 1) && opts.EmulateNuWro) {
+      // As in nuwro2rootracker partnum 1 should have P4 of the struck
+      // nucleon but the PDG of the target
+      outRooTracker->StdHepPdg[saveInd] =
+          Utils::MakeNuclearPDG(vector->TargetZ, vector->TargetA);
+      // Now save the struck nucleon properties
+      outRooTracker->StdHepP4[saveInd][kNStdHepIdxPx] =
+          part.fP.Px() * EUnitScaleFactor;
+      outRooTracker->StdHepP4[saveInd][kNStdHepIdxPy] =
+          part.fP.Py() * EUnitScaleFactor;
+      outRooTracker->StdHepP4[saveInd][kNStdHepIdxPz] =
+          part.fP.Pz() * EUnitScaleFactor;
+      outRooTracker->StdHepP4[saveInd][kNStdHepIdxE] =
+          part.fP.E() * EUnitScaleFactor;
+
+      outRooTracker->StruckNucleonPDG = part.fPID;
+      if (!opts.LiteMode) {
+        FullRooTracker->NEstdhepvc[partNum] = saveInd;
+      }
+
+      // Not implemented in NEUT
+      if (!opts.LiteMode) {
+        (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxX];
+        (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxY];
+        (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxZ];
+        (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxT];
+        (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPx];
+        (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPy];
+        (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPz];
+        (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxE];
+      }
+      ++saveInd;
+      continue;
+    } else if (partNum == 1) {
+      // As in TNeutOutput, to emulate neutgeom
+      // StdHepX[1] is the target
+      outRooTracker->StdHepPdg[saveInd] =
+          Utils::MakeNuclearPDG(vector->TargetZ, vector->TargetA);
+      outRooTracker->StdHepP4[saveInd][kNStdHepIdxE] = vector->TargetA;
+      // Now incremebent the saveInd to save the struck nucleon properties
+      // but don't continue
+      // Not implemented in NEUT
+      if (!opts.LiteMode) {
+        (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxX];
+        (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxY];
+        (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxZ];
+        (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxT];
+        (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPx];
+        (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPy];
+        (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPz];
+        (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxE];
+      }
+      ++saveInd;
+    }
+
+    outRooTracker->StdHepPdg[saveInd] = part.fPID;
+
+    switch (part.fStatus) {
+      case -1: {  // Initial state
+        outRooTracker->StdHepStatus[saveInd] = 0;
+        break;
+      }
+      case 0: {  // Good
+        if (part.fIsAlive == 1) {
+          outRooTracker->StdHepStatus[saveInd] = 1;
+        } else {  // But also bad!?
+          outRooTracker->StdHepStatus[saveInd] = 2;
+          if (opts.SkipNonFS) {
+            UDBVerbose(
+                "Not saving particle status ("
+                << part.fStatus << ":\"" << NEUTStatusCodes[part.fStatus]
+                << "\") as it was not 'IsAlive' in event: " << entryNum);
+            continue;
+          }
+        }
+        break;
+      }
+      case 2: {  // Escaped detector == Good
+        if (part.fIsAlive == 1) {
+          outRooTracker->StdHepStatus[saveInd] = 1;
+          UDBWarn("Found NEUT status 2:\""
+                  << NEUTStatusCodes[part.fStatus]
+                  << "\" which was marked as "
+                     "IsAlive. (PDG:"
+                  << outRooTracker->StdHepPdg[saveInd]
+                  << ") in event: " << entryNum);
+        } else {  // But also bad.
+          outRooTracker->StdHepStatus[saveInd] = 2;
+          if (opts.SkipNonFS) {
+            UDBVerbose("Not saving particle status("
+                       << part.fStatus << ":\""
+                       << NEUTStatusCodes[part.fStatus]
+                       << "\") as it was not 'IsAlive'. (PDG:"
+                       << outRooTracker->StdHepPdg[saveInd]
+                       << ") in event: " << entryNum);
+            continue;
+          }
+        }
+        break;
+      }
+      default: {
+        UDBWarn("Found unexpected neut fStatus code: "
+                << part.fStatus << ":\"" << NEUTStatusCodes[part.fStatus]
+                << "\" in event: " << entryNum);
+        outRooTracker->StdHepStatus[saveInd] = part.fStatus;
+        if (opts.SkipNonFS) {
+          continue;
+        }
+      }
+    }
+    // TODO Check MEC events
+    if ((!opts.EmulateNuWro) && (partNum == 1) &&
+        (part.fStatus == -1)) {
+      outRooTracker->StdHepStatus[saveInd] =
+          11;  // To sync with GENIE code for
+      // Struck Nucleon.
+    }
+
+    outRooTracker->StdHepP4[saveInd][kNStdHepIdxPx] =
+        part.fP.Px() * EUnitScaleFactor;
+    outRooTracker->StdHepP4[saveInd][kNStdHepIdxPy] =
+        part.fP.Py() * EUnitScaleFactor;
+    outRooTracker->StdHepP4[saveInd][kNStdHepIdxPz] =
+        part.fP.Pz() * EUnitScaleFactor;
+    outRooTracker->StdHepP4[saveInd][kNStdHepIdxE] =
+        part.fP.E() * EUnitScaleFactor;
+
+    // Not implemented in NEUT
+    if (!opts.LiteMode) {
+      (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxX];
+      (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxY];
+      (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxZ];
+      (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxT];
+      (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPx];
+      (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPy];
+      (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPz];
+      (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxE];
+      FullRooTracker->NEstdhepvc[partNum] = saveInd;
+    }
+    saveInd++;
+  }  // end for(int partNum = 0; partNum < vector->Npart(); ++partNum)
+
+  outRooTracker->StdHepN = saveInd;
+
+  UDBVerbose("(Interation Mode: " << vector->Mode << ")");
+  for (int it = 0; it < outRooTracker->StdHepN; ++it) {
+    UDBVerbose(((it > 0) ? "Particle:" : "Incoming Neutrino:")
+               << " " << it << "/" << outRooTracker->StdHepN
+               << "(VectNPart:" << vector->Npart() << ")"
+               << "\n\tStdHEPPDG: " << outRooTracker->StdHepPdg[it]
+               << "\n\tStdHEPStatus: " << outRooTracker->StdHepStatus[it]
+               << "\n\tStdHEPP4: "
+               << Utils::PrintArray(outRooTracker->StdHepP4[it]));
+  }
+
+  if (!opts.LiteMode) {
+    //**************************************************
+    // NEUT VCWork Particles
+    FullRooTracker->NEnvc = vector->Npart();
+    for (int partNum = 0; partNum < FullRooTracker->NEnvc; ++partNum) {
+      const NeutPart& part = (*vector->PartInfo(partNum));
+
+      FullRooTracker->NEiflgvc[partNum] = part.fStatus;
+      FullRooTracker->NEicrnvc[partNum] = part.fIsAlive ? 1 : 0;
+
+      // Object outputs always stream the whole block.
+      if (!NeutToRooTrackerOpts::Schema.CompactVCWork || opts.ObjectOutput) {
+        FullRooTracker->NEpvc[partNum][0] = part.fP.Px() * EUnitScaleFactor;
+        FullRooTracker->NEpvc[partNum][1] = part.fP.Py() * EUnitScaleFactor;
+        FullRooTracker->NEpvc[partNum][2] = part.fP.Pz() * EUnitScaleFactor;
+        FullRooTracker->NEipvc[partNum] = part.fPID;
+        FullRooTracker->NEiorgvc[partNum] = 0;
+      } else if (FullRooTracker->NEstdhepvc[partNum] < 0) {
+        // Only particles that didn't make it to StdHep need saving again.
+        int extraInd = FullRooTracker->NEnvcx++;
+        FullRooTracker->NEpvcx[extraInd][0] = part.fP.Px() * EUnitScaleFactor;
+        FullRooTracker->NEpvcx[extraInd][1] = part.fP.Py() * EUnitScaleFactor;
+        FullRooTracker->NEpvcx[extraInd][2] = part.fP.Pz() * EUnitScaleFactor;
+        FullRooTracker->NEipvcx[extraInd] = part.fPID;
+        FullRooTracker->NEstdhepvc[partNum] = -(extraInd + 1);
+      }
+    }
+
+    //**************************************************
+    // NEUT Pion FSI interaction history
+    FullRooTracker->NEnvert = vector->NfsiVert();
+
+    for (int FSIVertNum = 0; FSIVertNum < FullRooTracker->NEnvert;
+         ++FSIVertNum) {
+      const NeutFsiVert& fsiVert = (*vector->FsiVertInfo(FSIVertNum));
+      FullRooTracker->NEposvert[FSIVertNum][0] = fsiVert.fPos.X();
+      FullRooTracker->NEposvert[FSIVertNum][1] = fsiVert.fPos.Y();
+      FullRooTracker->NEposvert[FSIVertNum][2] = fsiVert.fPos.Z();
+      FullRooTracker->NEiflgvert[FSIVertNum] = fsiVert.fVertID;
+    }
+
+    FullRooTracker->NEnvcvert = vector->NfsiPart();
+    for (int FSIPartNum = 0; FSIPartNum < FullRooTracker->NEnvcvert;
+         ++FSIPartNum) {
+      const NeutFsiPart& fsiPart = (*vector->FsiPartInfo(FSIPartNum));
+
+      FullRooTracker->NEdirvert[FSIPartNum][0] = fsiPart.fDir.X();
+      FullRooTracker->NEdirvert[FSIPartNum][1] = fsiPart.fDir.Y();
+      FullRooTracker->NEdirvert[FSIPartNum][2] = fsiPart.fDir.Z();
+      FullRooTracker->NEabspvert[FSIPartNum] =
+          fsiPart.fMomLab * EUnitScaleFactor;
+      FullRooTracker->NEabstpvert[FSIPartNum] =
+          fsiPart.fMomNuc * EUnitScaleFactor;
+      FullRooTracker->NEipvert[FSIPartNum] = fsiPart.fPID;
+      FullRooTracker->NEiverti[FSIPartNum] = fsiPart.fVertStart;
+      FullRooTracker->NEivertf[FSIPartNum] = fsiPart.fVertEnd;
+    }
+
+#ifdef HAVE_NUCLEON_FSI_TRACKING
+
+    //**************************************************
+    // NEUT Nucleon FSI interaction history
+    FullRooTracker->NFnvert = vector->NnucFsiVert();
+    for (int NucFSIPartNum = 0; NucFSIPartNum < FullRooTracker->NFnvert;
+         ++NucFSIPartNum) {
+      const NeutNucFsiVert& nucFSIPart =
+          (*vector->NucFsiVertInfo(NucFSIPartNum));
+
+      FullRooTracker->NFiflag[NucFSIPartNum] = nucFSIPart.fVertFlag;
+      FullRooTracker->NFx[NucFSIPartNum] = nucFSIPart.fPos.X();
+      FullRooTracker->NFy[NucFSIPartNum] = nucFSIPart.fPos.Y();
+      FullRooTracker->NFz[NucFSIPartNum] = nucFSIPart.fPos.Z();
+      FullRooTracker->NFpx[NucFSIPartNum] = nucFSIPart.fMom.X();
+      FullRooTracker->NFpy[NucFSIPartNum] = nucFSIPart.fMom.X();
+      FullRooTracker->NFpz[NucFSIPartNum] = nucFSIPart.fMom.X();
+      FullRooTracker->NFe[NucFSIPartNum] = nucFSIPart.fMom.X();
+      FullRooTracker->NFfirststep[NucFSIPartNum] = nucFSIPart.fVertFirstStep;
+    }
+
+    FullRooTracker->NFnstep = vector->NnucFsiStep();
+    for (int NucFSIStepNum = 0; NucFSIStepNum < FullRooTracker->NFnstep;
+         ++NucFSIStepNum) {
+      const NeutNucFsiStep& nucFSIStep =
+          (*vector->NucFsiStepInfo(NucFSIStepNum));
+      FullRooTracker->NFecms2[NucFSIStepNum] = nucFSIStep.fECMS2;
+      FullRooTracker->NFProb[NucFSIStepNum] = nucFSIStep.fProb;
+    }
+
+#endif
+  }  // end if(!opts.LiteMode)
+}
+
+///\brief An output file and its trees. A sink writes to one of these for each
+/// interaction mode group when splitting by mode.
+struct SinkOutput {
+  SinkOutput(std::string const& fname)
+      : FName(fname),
+        OutFile(nullptr),
+        RooTrackerTree(nullptr),
+        MetaTree(nullptr),
+        FSIFile(nullptr),
+        FSITree(nullptr),
+        FilledEntries(0) {}
+  ~SinkOutput() {
+    if (OutFile) {
+      delete OutFile;
+    }
+    if (FSIFile) {
+      delete FSIFile;
+    }
+  }
+
+  std::string FName;
+  TFile* OutFile;
+  TTree* RooTrackerTree;
+  TTree* MetaTree;
+  ///Only set if the FSI history friend tree is written to its own file.
+  TFile* FSIFile;
+  TTree* FSITree;
+  ///Bound to the MetaTree branches.
+  NRooTrackerFileMeta FileMeta;
+  ///The metadata for each input file read since this output was opened.
+  std::vector<NRooTrackerFileMeta> FileMetas;
+  long FilledEntries;
+};
+
+///\brief The event buffers that each input event is converted into for a set
+/// of output options, along with the output files that they are written to.
+struct OutputSink {
+  OutputSink(SinkOpts const& opts)
+      : Opts(opts),
+        OutRooTracker(nullptr),
+        FullRooTracker(nullptr),
+        Skim(NeutToRooTrackerOpts::Skim),
+        MemMonitor(nullptr),
+        ReadingFile(false) {
+    if (Opts.OutputInGev) {
+      Skim.SetEUnitScaleFactor(1.0 / 1000);
+    }
+    if (Opts.LiteMode) {
+      OutRooTracker = new NRooTrackerVtxB();
+    } else {
+      FullRooTracker = new NRooTrackerVtx();
+      OutRooTracker = FullRooTracker;
+    }
+  }
+  ~OutputSink() {
+    for (auto& out : Outputs) {
+      delete out.second;
+    }
+    delete OutRooTracker;
+  }
+
+  ///\brief Opens the output file, unless splitting by mode, in which case
+  /// each group's output file is opened when its first event is written.
+  ///
+  ///\details Output trees are added to \c monitor, which may be \c nullptr.
+  int Open(MemoryBudget::Monitor* monitor) {
+    MemMonitor = monitor;
+    if (Opts.ObjectOutput && NeutToRooTrackerOpts::Schema.FileMetadata) {
+      // The per-file members would still be streamed with every event.
+      UDBError("Per-file metadata (-F) cannot be used with object output: "
+               << Opts.OutFName);
+      return 8;
+    }
+    if (Opts.ObjectOutput && FullRooTracker &&
+        NeutToRooTrackerOpts::Schema.CompactVCWork) {
+      UDBWarn("The compact NEUT VCWork block (-C) is ignored for object "
+              "output: " << Opts.OutFName);
+    }
+    if ((Opts.ObjectOutput || !FullRooTracker) &&
+        NeutToRooTrackerOpts::Schema.FSIFriend) {
+      UDBWarn("The FSI history friend tree (-H) is ignored for Lite and "
+              "object output: " << Opts.OutFName);
+    }
+    NRooTrackerSchema const& Schema = NeutToRooTrackerOpts::Schema;
+    if (Opts.ObjectOutput &&
+        ((Schema.P4Precision.Pol == NRooTrackerPrecision::kTruncated) ||
+         (FullRooTracker &&
+          ((Schema.X4Precision.Pol == NRooTrackerPrecision::kTruncated) ||
+           (Schema.PolzPrecision.Pol == NRooTrackerPrecision::kTruncated))))) {
+      UDBWarn("The trunc precision policies (-P) only quantize object "
+              "output, the values are still streamed as full doubles: "
+              << Opts.OutFName);
+    }
+    if (NeutToRooTrackerOpts::SplitByMode) {
+      return 0;
+    }
+    return GetOutput("") ? 0 : 8;
+  }
+
+  ///\brief Returns the output for a mode group, opening it if needed.
+  ///
+  ///\details Returns \c nullptr if the file could not be opened.
+  SinkOutput* GetOutput(std::string const& group) {
+    std::map<std::string, SinkOutput*>::iterator out = Outputs.find(group);
+    if (out != Outputs.end()) {
+      return out->second;
+    }
+
+    SinkOutput* output = new SinkOutput(GetGroupFName(group));
+    Outputs[group] = output;
+
+    output->OutFile = new TFile(output->FName.c_str(), "RECREATE");
+    if (!output->OutFile->IsOpen()) {
+      UDBError("Couldn't open output file: " << output->FName);
+      return nullptr;
+    } else {
+      UDBInfo("Created output file: " << output->OutFile->GetName());
+    }
+
+    output->RooTrackerTree = new TTree("nRooTracker", "Pure NEUT RooTracker");
+    if (Opts.ObjectOutput) {
+      output->RooTrackerTree->Branch("nRooTracker", &OutRooTracker);
+    } else {
+      OutRooTracker->AddBranches(output->RooTrackerTree, Opts.SaveIsBound,
+                                 Opts.EmulateNuWro,
+                                 NeutToRooTrackerOpts::Schema);
+    }
+
+    if (NeutToRooTrackerOpts::Schema.FileMetadata) {
+      output->MetaTree = new TTree("nRooTrackerMeta",
+                                   "Per input file NEUT RooTracker constants");
+      output->FileMeta.AddBranches(output->MetaTree);
+      // Outputs opened part way through an input file start from there.
+      if (ReadingFile) {
+        NewFile(output, CurrentFile);
+      }
+    }
+
+    if (NeutToRooTrackerOpts::Schema.FSIFriend && FullRooTracker &&
+        (!Opts.ObjectOutput)) {
+      if (NeutToRooTrackerOpts::FSIFriendSeparateFile) {
+        std::string FSIFName = AddFNameTag(output->FName, "fsi");
+        output->FSIFile = new TFile(FSIFName.c_str(), "RECREATE");
+        if (!output->FSIFile->IsOpen()) {
+          UDBError("Couldn't open FSI output file: " << FSIFName);
+          return nullptr;
+        } else {
+          UDBInfo("Created FSI output file: " << output->FSIFile->GetName());
+        }
+      } else {
+        output->OutFile->cd();
+      }
+      output->FSITree =
+          new TTree(NRooTrackerVtx::kFSITreeName, "NEUT FSI history");
+      FullRooTracker->AddFSIBranches(output->FSITree);
+    }
+
+    if (MemMonitor) {
+      MemMonitor->AddOutputTree(output->RooTrackerTree);
+      if (output->FSITree) {
+        MemMonitor->AddOutputTree(output->FSITree);
+      }
+    }
+    return output;
+  }
+
+  ///Inserts the mode group name before the \c .root extension.
+  std::string GetGroupFName(std::string const& group) const {
+    if (!group.length()) {
+      return Opts.OutFName;
+    }
+    return AddFNameTag(Opts.OutFName, group);
+  }
+
+  /// Called each time that the input moves on to a new file.
+  void NewFile(NRooTrackerFileMeta const& file) {
+    CurrentFile = file;
+    ReadingFile = true;
+    for (auto& out : Outputs) {
+      NewFile(out.second, file);
+    }
+  }
+
+  void NewFile(SinkOutput* output, NRooTrackerFileMeta const& file) {
+    if (output->MetaTree) {
+      output->FileMetas.push_back(file);
+      output->FileMetas.back().FirstOutputEntry = output->FilledEntries;
+      output->FileMetas.back().NOutputEntries = 0;
+    }
+  }
+
+  ///\brief Converts and writes a single input event.
+  ///
+  ///\details Returns non-zero if the output file for the event's mode group
+  /// could not be opened.
+  int Fill(NeutVect* vector, NeutVtx* vtx, NRooTrackerFileMeta const& file,
+           long entryNum) {
+    ConvertEvent(Opts, vector, vtx, file, entryNum, OutRooTracker,
+                 FullRooTracker);
+
+    if (Skim.IsActive() && !Skim.Pass(*OutRooTracker)) {
+      UDBVerbose("Event " << entryNum << " failed the topology skim.");
+      OutRooTracker->Reset();
+      return 0;
+    }
+
+    SinkOutput* output =
+        GetOutput(NeutToRooTrackerOpts::GetModeGroup(vector->Mode));
+    if (!output) {
+      OutRooTracker->Reset();
+      return 8;
+    }
+
+    if (Opts.ObjectOutput) {
+      OutRooTracker->RoundToPrecision(NeutToRooTrackerOpts::Schema);
+    }
+
+    output->RooTrackerTree->Fill();
+    if (output->FSITree) {
+      output->FSITree->Fill();
+    }
+    output->FilledEntries++;
+    if (output->MetaTree) {
+      output->FileMetas.back().NOutputEntries++;
+    }
+    UDBVerbose("*****************Filled*****************\n");
+    OutRooTracker->Reset();
+    return 0;
+  }
+
+  /// Writes the output trees and closes the output files.
+  void Close() {
+    if (Skim.IsActive()) {
+      Skim.Report(Opts.OutFName);
+    }
+
+    for (auto& out : Outputs) {
+      SinkOutput* output = out.second;
+      if (!output->RooTrackerTree) {
+        continue;
+      }
+      UDBLog("Wrote " << output->FilledEntries << " events to "
+                      << output->FName);
+
+      output->OutFile->cd();
+      if (output->MetaTree) {
+        for (NRooTrackerFileMeta const& meta : output->FileMetas) {
+          output->FileMeta = meta;
+          output->MetaTree->Fill();
+        }
+        // Lets the aliases in the event tree find the right metadata entry
+        output->MetaTree->BuildIndex("FileIndex");
+        output->RooTrackerTree->AddFriend(output->MetaTree);
+        output->MetaTree->Write();
+      }
+
+      output->RooTrackerTree->Write();
+
+      if (output->FSITree) {
+        if (output->FSIFile) {
+          output->FSIFile->cd();
+        }
+        output->FSITree->Write();
+        if (output->FSIFile) {
+          output->FSIFile->Close();
+        }
+      }
+      output->OutFile->Close();
+    }
+  }
+
+  ///Returns the number of events written to all of the outputs.
+  long GetNFilled() const {
+    long NFilled = 0;
+    for (auto const& out : Outputs) {
+      NFilled += out.second->FilledEntries;
+    }
+    return NFilled;
+  }
+
+  SinkOpts Opts;
+  NRooTrackerVtxB* OutRooTracker;
+  NRooTrackerVtx* FullRooTracker;
+  ///This output's copy of the topology skim, keeps its own pass counts.
+  TopologySkim::Skim Skim;
+  MemoryBudget::Monitor* MemMonitor;
+  ///The metadata of the input file currently being read.
+  NRooTrackerFileMeta CurrentFile;
+  bool ReadingFile;
+  ///The output for each mode group, keyed by group name. The only group is
+  ///\c "" when not splitting by mode.
+  std::map<std::string, SinkOutput*> Outputs;
+};
+
+///\brief Builds the list of input entries to convert when sampling.
+///
+///\details The sample is drawn over the global entry numbers of the whole
+/// chain, so it is spread evenly over all input files. The number of entries
+/// selected from each file is written to \c NSelectedPerTree, indexed by
+/// tree number.
+TEntryList* BuildSampleList(TChain* chain,
+                            std::vector<Long64_t>& NSelectedPerTree) {
+  Long64_t NEntries = chain->GetEntries();
+  Long64_t const* TreeOffsets = chain->GetTreeOffset();
+  Int_t NTrees = chain->GetNtrees();
+  NSelectedPerTree.assign(NTrees, 0);
+
+  TEntryList* SampleList =
+      new TEntryList("NeutToRooTrackerSample", "Sampled input entries");
+  TRandom3 rand(NeutToRooTrackerOpts::SampleSeed);
+  Int_t TreeNum = 0;
+  for (Long64_t entry = 0; entry < NEntries; ++entry) {
+    bool Selected = NeutToRooTrackerOpts::SampleEvery
+                        ? (!(entry % NeutToRooTrackerOpts::SampleEvery))
+                        : (rand.Rndm() < NeutToRooTrackerOpts::SampleFraction);
+    if (!Selected) {
+      continue;
+    }
+    while (((TreeNum + 1) < NTrees) && (entry >= TreeOffsets[TreeNum + 1])) {
+      TreeNum++;
+    }
+    SampleList->Enter(entry, chain);
+    NSelectedPerTree[TreeNum]++;
+  }
+  return SampleList;
+}
+
+///\brief Where the NEUT events to convert are read from.
+struct InputSource {
+  InputSource()
+      : vector(new NeutVect()),
+        vtx(new NeutVtx()),
+        EntryNum(0),
+        NewFile(false) {}
+  virtual ~InputSource() {
+    delete vector;
+    delete vtx;
+  }
+
+  ///Prepares the input, returns non-zero on failure.
+  virtual int Open() = 0;
+  ///\brief Reads the next event into \c vector and \c vtx.
+  ///
+  ///\details Returns false when there are no more events, or on failure, in
+  /// which case \c GetError returns non-zero. Sets \c NewFile if this event is
+  /// the first from a new input file, in which case \c File has been updated.
+  virtual bool Next() = 0;
+  virtual int GetError() const { return 0; }
+  ///\brief Returns the approximate size of the input buffers in bytes.
+  ///
+  ///\details May read an event to find out.
+  virtual Long64_t GetEventBufferSize() = 0;
+  ///Returns the input tree, if there is one, for the memory budget.
+  virtual TTree* GetTree() { return nullptr; }
+
+  NeutVect* vector;
+  NeutVtx* vtx;
+  ///The input entry number of the current event.
+  long EntryNum;
+  bool NewFile;
+  NRooTrackerFileMeta File;
+};
+
+///The events requested from a single input file by an event list.
+struct EventListFile {
+  std::string FName;
+  ///Requested by input entry number.
+  std::vector<Long64_t> Entries;
+  ///Requested by NeutVect::EventNo.
+  std::vector<Int_t> EventNos;
+};
+
+///\brief Reads an event list file.
+///
+///\details Each line is <tt><input file> <EventNo></tt> or
+/// <tt><input file> @<entry></tt>. Empty lines and lines starting with \c #
+/// are skipped. The files are kept in the order that they are first listed.
+bool ReadEventList(std::string const& FName,
+                   std::vector<EventListFile>& Files) {
+  std::ifstream ifs(FName.c_str());
+  if (!ifs.is_open()) {
+    UDBError("Couldn't open event list file: " << FName);
+    return false;
+  }
+
+  std::map<std::string, size_t> FileIndices;
+  std::string line;
+  long LineNumber = 0;
+  while (std::getline(ifs, line)) {
+    LineNumber++;
+    std::istringstream ss(line);
+    std::string File, Event, Extra;
+    if (!(ss >> File) || (File[0] == '#')) {
+      continue;
+    }
+    ss >> Event >> Extra;
+
+    bool ByEntry = (Event.length() && (Event[0] == '@'));
+    long Num;
+    if ((!Event.length()) || Extra.length() ||
+        (Utils::str2int(Num, Event.c_str() + (ByEntry ? 1 : 0)) !=
+         Utils::STRINT_SUCCESS) ||
+        (ByEntry && (Num < 0))) {
+      UDBError(FName << ":" << LineNumber
+                     << ": Could not parse event list entry: \"" << line
+                     << "\"");
+      return false;
+    }
+
+    if (!FileIndices.count(File)) {
+      FileIndices[File] = Files.size();
+      Files.push_back(EventListFile());
+      Files.back().FName = File;
+    }
+    EventListFile& elf = Files[FileIndices[File]];
+    if (ByEntry) {
+      elf.Entries.push_back(Num);
+    } else {
+      elf.EventNos.push_back(Num);
+    }
+  }
+
+  if (!Files.size()) {
+    UDBError("Found no events in event list file: " << FName);
+    return false;
+  }
+  return true;
+}
+
+///Reads events from the neuttree trees of neutroot files.
+struct ChainInput : public InputSource {
+  ChainInput(std::string const& InputFileDescriptor)
+      : Descriptor(InputFileDescriptor),
+        NeutTree(nullptr),
+        EntryList(nullptr),
+        Sampled(false),
+        NEntries(0),
+        NToRead(0),
+        ReadNum(0),
+        TFileUID(0) {}
+  ~ChainInput() {
+    if (EntryList) {
+      NeutTree->SetEntryList(nullptr);
+      delete EntryList;
+    }
+    if (NeutTree) {
+      delete NeutTree;
+    }
+  }
+
+  int Open() {
+    NeutTree = new TChain("neuttree");
+
+    // Only the files named in an event list are added to the chain.
+    std::vector<EventListFile> EventListFiles;
+    int nFiles = 0;
+    if (NeutToRooTrackerOpts::EventListFName.length()) {
+      if (!ReadEventList(NeutToRooTrackerOpts::EventListFName,
+                         EventListFiles)) {
+        return 2;
+      }
+      for (EventListFile const& elf : EventListFiles) {
+        if (NeutTree->Add(elf.FName.c_str()) != 1) {
+          UDBError("Event list input \"" << elf.FName
+                                         << "\" did not match exactly one "
+                                            "input file.");
+          return 2;
+        }
+        nFiles++;
+      }
+    } else {
+      nFiles = NeutTree->Add(Descriptor.c_str());
+    }
+
+    if (!nFiles) {
+      UDBError("\"" << Descriptor << "\" matched 0 input files.");
+      return 2;
+    }
+
+    NeutTree->SetBranchAddress("vectorbranch", &vector);
+    NeutTree->SetBranchAddress("vertexbranch", &vtx);
+
+    NEntries = NeutTree->GetEntries();
+
+    if (!NEntries) {
+      UDBError("Failed to find any entries (" << NEntries << ").");
+      return 4;
+    }
+    UDBLog("Reading " << nFiles << " input files with " << NEntries
+                      << " entries.");
+
+    // The chain only reads through the entry list so that its TTreeCache
+    // skips the clusters that contain no selected entries.
+    NToRead = NEntries;
+    if (EventListFiles.size()) {
+      EntryList = BuildEventList(EventListFiles);
+      UDBLog("Found " << EntryList->GetN() << " listed events.");
+    } else if (NeutToRooTrackerOpts::SampleEvery ||
+               (NeutToRooTrackerOpts::SampleFraction > 0)) {
+      EntryList = BuildSampleList(NeutTree, NSelectedPerTree);
+      Sampled = true;
+      UDBLog("Sampled " << EntryList->GetN() << "/" << NEntries
+                        << " entries.");
+    }
+    if (EntryList) {
+      if (!EntryList->GetN()) {
+        UDBError("Failed to select any entries.");
+        return 4;
+      }
+      NeutTree->SetEntryList(EntryList);
+      NToRead = EntryList->GetN();
+    }
+    return 0;
+  }
+
+  ///\brief Looks up the chain entry of each listed event.
+  ///
+  ///\details Events listed by EventNo are found with a \c TTreeIndex built on
+  /// \c vectorbranch.EventNo, which only reads that leaf, falling back to
+  /// reading each entry of the file if the index cannot be built.
+  TEntryList* BuildEventList(std::vector<EventListFile> const& Files) {
+    TEntryList* List =
+        new TEntryList("NeutToRooTrackerEvents", "Listed input entries");
+    Long64_t const* TreeOffsets = NeutTree->GetTreeOffset();
+    for (size_t f = 0; f < Files.size(); ++f) {
+      NeutTree->LoadTree(TreeOffsets[f]);
+      TTree* FileTree = NeutTree->GetTree();
+      Long64_t NFileEntries = FileTree->GetEntries();
+
+      for (Long64_t const& entry : Files[f].Entries) {
+        if (entry >= NFileEntries) {
+          UDBWarn("Entry " << entry << " is out of range for "
+                           << Files[f].FName << " (" << NFileEntries
+                           << " entries).");
+          continue;
+        }
+        List->Enter(TreeOffsets[f] + entry, NeutTree);
+      }
 
-int NeutToRooTracker(const char* InputFileDescriptor) {
-  // Input stuff
-  TChain* NeutTree = new TChain("neuttree");
+      if (!Files[f].EventNos.size()) {
+        continue;
+      }
+      std::map<Int_t, Long64_t> EventNoEntries;
+      bool Indexed = (FileTree->BuildIndex("vectorbranch.EventNo") > 0);
+      if (!Indexed) {
+        UDBInfo("Couldn't index " << Files[f].FName
+                                  << " by EventNo, reading each entry.");
+        for (Long64_t entry = 0; entry < NFileEntries; ++entry) {
+          NeutTree->GetEntry(TreeOffsets[f] + entry);
+          EventNoEntries.insert(std::make_pair(vector->EventNo, entry));
+        }
+      }
+      for (Int_t const& EventNo : Files[f].EventNos) {
+        Long64_t entry = -1;
+        if (Indexed) {
+          entry = FileTree->GetEntryNumberWithIndex(EventNo);
+        } else if (EventNoEntries.count(EventNo)) {
+          entry = EventNoEntries[EventNo];
+        }
+        if (entry < 0) {
+          UDBWarn("Couldn't find EventNo " << EventNo << " in "
+                                           << Files[f].FName << ".");
+          continue;
+        }
+        List->Enter(TreeOffsets[f] + entry, NeutTree);
+      }
+    }
+    return List;
+  }
+
+  bool Next() {
+    if (ReadNum >= NToRead) {
+      return false;
+    }
+    EntryNum = EntryList ? long(NeutTree->GetEntryNumber(ReadNum)) : ReadNum;
+    ReadNum++;
+    NeutTree->GetEntry(EntryNum);
 
-  int nFiles = NeutTree->Add(InputFileDescriptor);
+    NewFile = (NeutTree->GetFile()->GetUniqueID() != TFileUID);
+    if (!NewFile) {
+      return true;
+    }
+
+    TFileUID = NeutTree->GetFile()->GetUniqueID();
+    TH1D* flux_numu =
+        dynamic_cast<TH1D*>(NeutTree->GetFile()->Get("flux_numu"));
+    TH1D* evtrt_numu =
+        dynamic_cast<TH1D*>(NeutTree->GetFile()->Get("evtrt_numu"));
+
+    File.Reset();
+    File.FileIndex = NeutTree->GetTreeNumber();
+    (*File.FileName) = NeutTree->GetFile()->GetName();
+    File.FirstEntry = NeutTree->GetTreeOffset()[File.FileIndex];
+    File.NEntriesInFile = NeutTree->GetTree()->GetEntries();
+    if (Sampled) {
+      // Normalise to the sampled entries, so that EvtWght still sums to
+      // the whole file's event rate.
+      UDBLog("Sampled " << NSelectedPerTree[File.FileIndex] << "/"
+                        << File.NEntriesInFile << " entries from this file.");
+      File.NEntriesInFile = NSelectedPerTree[File.FileIndex];
+    }
+    File.NeutVectClassVersion = NeutVect::Class_Version();
+
+    if (flux_numu && evtrt_numu) {
+      File.FluxIntegral = flux_numu->Integral();
+      File.EvtRateIntegral = evtrt_numu->Integral();
+      File.EvtHistWght = File.EvtRateIntegral / File.NEntriesInFile;
+      File.EvtWght =
+          File.EvtRateIntegral / (File.FluxIntegral * File.NEntriesInFile);
+    }
 
-  if (!nFiles) {
-    UDBError("\"" << InputFileDescriptor << "\" matched 0 input files.");
-    return 2;
+    UDBLog("Opened new file: " << NeutTree->GetFile()->GetName()
+                               << " on entry " << EntryNum << "/" << NEntries
+                               << " (" << File.NEntriesInFile
+                               << " entries in this file), EvtWght: "
+                               << File.EvtWght);
+    return true;
   }
 
-  NeutVect* vector = new NeutVect();
-  NeutTree->SetBranchAddress("vectorbranch", &vector);
-  NeutVtx* vtx = new NeutVtx();
-  NeutTree->SetBranchAddress("vertexbranch", &vtx);
+  Long64_t GetEventBufferSize() {
+    // Read the first entry to find out how big the input event buffers are.
+    return 2 * NeutTree->GetEntry(0);
+  }
 
-  long NEntries = NeutTree->GetEntries();
-  long FilledEntries = 0;
-  long IgnoredEntries = 0;
+  TTree* GetTree() { return NeutTree; }
+
+  std::string Descriptor;
+  TChain* NeutTree;
+  ///The entries to read when sampling or reading an event list.
+  TEntryList* EntryList;
+  bool Sampled;
+  std::vector<Long64_t> NSelectedPerTree;
+  long NEntries;
+  long NToRead;
+  long ReadNum;
+  UInt_t TFileUID;
+};
+
+///\brief Reads events from a text stream, see NeutStream.
+///
+///\details Allows events to be converted as they are generated, by reading
+/// from \c stdin or a named pipe.
+struct StreamInput : public InputSource {
+  StreamInput(std::string const& FileName)
+      : FName(FileName),
+        InFile(nullptr),
+        Reader(nullptr),
+        NRead(0),
+        FileNumber(-1),
+        Error(0) {}
+  ~StreamInput() {
+    if (Reader) {
+      delete Reader;
+    }
+    if (InFile) {
+      delete InFile;
+    }
+  }
 
-  if (!NEntries) {
-    UDBError("Failed to find any entries (" << NEntries << ").");
-    return 4;
+  int Open() {
+    if (NeutToRooTrackerOpts::SampleEvery ||
+        (NeutToRooTrackerOpts::SampleFraction > 0)) {
+      UDBError("Sampling (-p) is not supported for streamed input.");
+      return 2;
+    }
+    if (FName == "-") {
+      Reader = new NeutStream::Reader(std::cin, "stdin");
+    } else {
+      InFile = new std::ifstream(FName.c_str());
+      if (!InFile->is_open()) {
+        UDBError("Couldn't open input stream: " << FName);
+        return 2;
+      }
+      Reader = new NeutStream::Reader(*InFile, FName);
+    }
+    UDBLog("Reading events from stream: " << Reader->GetName());
+    return 0;
   }
-  UDBLog("Reading " << nFiles << " input files with " << NEntries
-                    << " entries.");
 
-  // Output stuff
-  TFile* outFile =
-      new TFile(NeutToRooTrackerOpts::OutFName.c_str(), "RECREATE");
+  bool Next() {
+    NeutStream::Reader::Status status = Reader->Next(vector, vtx);
+    if (status != NeutStream::Reader::kEvent) {
+      Error = (status == NeutStream::Reader::kError) ? 4 : 0;
+      return false;
+    }
+    EntryNum = NRead++;
 
-  if (!outFile->IsOpen()) {
-    UDBError("Couldn't open output file: " << NeutToRooTrackerOpts::OutFName);
-    return 8;
-  } else {
-    UDBInfo("Created output file: " << outFile->GetName());
+    NewFile = (Reader->GetFileNumber() != FileNumber);
+    if (!NewFile) {
+      return true;
+    }
+    FileNumber = Reader->GetFileNumber();
+
+    NeutStream::FileInfo const& info = Reader->GetFileInfo();
+    File.Reset();
+    File.FileIndex = FileNumber;
+    (*File.FileName) = Reader->GetName().c_str();
+    File.FirstEntry = EntryNum;
+    File.NEntriesInFile = info.NEntries;
+    File.NeutVectClassVersion = NeutVect::Class_Version();
+    if (info.NEntries && info.FluxIntegral) {
+      File.FluxIntegral = info.FluxIntegral;
+      File.EvtRateIntegral = info.EvtRateIntegral;
+      File.EvtHistWght = File.EvtRateIntegral / File.NEntriesInFile;
+      File.EvtWght =
+          File.EvtRateIntegral / (File.FluxIntegral * File.NEntriesInFile);
+    }
+    UDBLog("Started stream file " << FileNumber << " on entry " << EntryNum
+                                  << " (" << File.NEntriesInFile
+                                  << " entries in this file), EvtWght: "
+                                  << File.EvtWght);
+    return true;
   }
 
-  TTree* rooTrackerTree = new TTree("nRooTracker", "Pure NEUT RooTracker");
-  NRooTrackerVtxB* outRooTracker = nullptr;
-  NRooTrackerVtx* FullRooTracker = nullptr;
-  if (NeutToRooTrackerOpts::LiteMode) {
-    outRooTracker = new NRooTrackerVtxB();
-  } else {
-    FullRooTracker = new NRooTrackerVtx();
-    outRooTracker = FullRooTracker;
+  int GetError() const { return Error; }
+
+  Long64_t GetEventBufferSize() {
+    return sizeof(NeutVect) + sizeof(NeutVtx);
   }
 
-  if (NeutToRooTrackerOpts::ObjectOutput) {
-    rooTrackerTree->Branch("nRooTracker", &outRooTracker);
+  std::string FName;
+  std::ifstream* InFile;
+  NeutStream::Reader* Reader;
+  long NRead;
+  Int_t FileNumber;
+  int Error;
+};
+
+///Counts from a single conversion.
+struct ConversionStats {
+  ConversionStats() : NRead(0), NWritten(0) {}
+  ///Number of input events read.
+  long NRead;
+  ///Number of events written, summed over all outputs.
+  long NWritten;
+};
+
+///\brief Converts the events from \c InputFileDescriptor into an output for
+/// each of \c SinkList.
+///
+///\details Returns non-zero on failure. Only uses its own input and output
+/// buffers, so that several can run at once in different threads.
+int NeutToRooTracker(const char* InputFileDescriptor,
+                     std::vector<SinkOpts> const& SinkList,
+                     ConversionStats& Stats) {
+  // Input stuff
+  InputSource* Input = nullptr;
+  std::string Descriptor = InputFileDescriptor;
+  if (Descriptor == "-") {
+    Input = new StreamInput(Descriptor);
+  } else if (!Descriptor.find("stream:")) {
+    Input = new StreamInput(Descriptor.substr(7));
   } else {
-    outRooTracker->AddBranches(rooTrackerTree,
-                               NeutToRooTrackerOpts::SaveIsBound,
-                               NeutToRooTrackerOpts::EmulateNuWro);
+    Input = new ChainInput(Descriptor);
   }
 
-  float EUnitScaleFactor = 1.0;
-  if (NeutToRooTrackerOpts::OutputInGev) {
-    EUnitScaleFactor = 1.0 / 1000;
+  int rtncode = Input->Open();
+  if (rtncode) {
+    delete Input;
+    return rtncode;
+  }
+  long IgnoredEntries = 0;
+
+  // Output stuff
+  std::vector<OutputSink*> Sinks;
+  for (SinkOpts const& opts : SinkList) {
+    Sinks.push_back(new OutputSink(opts));
   }
 
-  long long doEntries =
-      (NeutToRooTrackerOpts::MaxEntries == -1)
-          ? NEntries
-          : (std::min(NeutToRooTrackerOpts::MaxEntries, NEntries));
-  UInt_t TFileUID = 0;
-  Double_t EvtWght = 0, EvtHistWght = 0;
-  Double_t NEntriesInFile = 0;
-  for (long entryNum = 0; entryNum < doEntries; ++entryNum) {
-    if (entryNum && (!(entryNum % 10000))) {
-      UDBInfo("Read " << entryNum << " entries.");
+  Long64_t OutputEventBuffers = 0;
+  for (OutputSink* sink : Sinks) {
+    OutputEventBuffers += sink->OutRooTracker->GetEventBufferSize();
+  }
+
+  MemoryBudget::Monitor* MemMonitor = nullptr;
+  if (NeutToRooTrackerOpts::MaxMemoryMB > 0) {
+    Long64_t Baseline = MemoryBudget::GetCurrentRSS();
+    MemoryBudget::Plan plan = MemoryBudget::MakePlan(
+        Long64_t(NeutToRooTrackerOpts::MaxMemoryMB) * 1024 * 1024, Baseline,
+        OutputEventBuffers + Input->GetEventBufferSize());
+    MemMonitor = new MemoryBudget::Monitor(plan, Input->GetTree());
+  }
+
+  for (OutputSink* sink : Sinks) {
+    if ((rtncode = sink->Open(MemMonitor))) {
+      break;
     }
+  }
 
-    if (!entryNum) {
-      UDBDebug("Reading first entry... ");
+  NeutVect* vector = Input->vector;
+  NeutVtx* vtx = Input->vtx;
+  bool TimedFirstEvent = false;
+  for (long readNum = 0;
+       (!rtncode) && ((NeutToRooTrackerOpts::MaxEntries == -1) ||
+                      (readNum < NeutToRooTrackerOpts::MaxEntries));
+       ++readNum) {
+    if (readNum && (!(readNum % 10000))) {
+      UDBInfo("Read " << readNum << " entries.");
     }
 
-    NeutTree->GetEntry(entryNum);
-    if (!entryNum) {
-      UDBDebug("Read first entry!");
+    if (MemMonitor && readNum && (!(readNum % 1000))) {
+      MemMonitor->Check();
     }
 
-    if (NeutTree->GetFile()->GetUniqueID() != TFileUID) {
-      TFileUID = NeutTree->GetFile()->GetUniqueID();
-      TH1D* flux_numu =
-          dynamic_cast<TH1D*>(NeutTree->GetFile()->Get("flux_numu"));
-      TH1D* evtrt_numu =
-          dynamic_cast<TH1D*>(NeutTree->GetFile()->Get("evtrt_numu"));
+    if (!readNum) {
+      UDBDebug("Reading first entry... ");
+    }
 
-      NEntriesInFile = NeutTree->GetTree()->GetEntries();
-      UDBLog("Opened new file: "
-             << NeutTree->GetFile()->GetName() << " on entry " << entryNum
-             << "/" << NEntries << " (" << NEntriesInFile
-             << " entries in this file), EvtWght: " << EvtWght);
+    if (!Input->Next()) {
+      rtncode = Input->GetError();
+      break;
+    }
+    Stats.NRead++;
+    if (!readNum) {
+      UDBDebug("Read first entry!");
+    }
 
-      if (!flux_numu || !evtrt_numu) {
-        EvtHistWght = 0;
-        EvtWght = 0;
-      } else {
-        EvtHistWght = evtrt_numu->Integral() / double(NEntriesInFile);
-        EvtWght = evtrt_numu->Integral() / (flux_numu->Integral()*double(NEntriesInFile));
+    if (Input->NewFile) {
+      for (OutputSink* sink : Sinks) {
+        sink->NewFile(Input->File);
       }
     }
 
@@ -219,42 +1470,6 @@ int NeutToRooTracker(const char* InputFileDescriptor) {
       }
     }
 
-    //**************************************************
-    // Event Level
-    std::stringstream ss("");
-    ss << vector->Mode;
-    outRooTracker->EvtCode->SetString(ss.str().c_str());
-    outRooTracker->EvtNum = vector->EventNo;
-
-    if (!NeutToRooTrackerOpts::LiteMode) {
-      FullRooTracker->EvtXSec = vector->Totcrs;
-      FullRooTracker->EvtWght = EvtWght;
-      FullRooTracker->EvtHistWght = EvtHistWght;
-      FullRooTracker->NEntriesInFile = NEntriesInFile;
-
-      FullRooTracker->NEcrsx = vector->Crsx;
-      FullRooTracker->NEcrsy = vector->Crsy;
-      FullRooTracker->NEcrsz = vector->Crsz;
-      FullRooTracker->NEcrsphi = vector->Crsphi;
-
-      if (vtx->Nvtx() != 1) {
-        UDBWarn("Vertex entry " << entryNum << " had " << vtx->Nvtx()
-                                << " entries, expected 1.");
-        FullRooTracker->EvtVtx[0] = 0.0;
-        FullRooTracker->EvtVtx[1] = 0.0;
-        FullRooTracker->EvtVtx[2] = 0.0;
-        FullRooTracker->EvtVtx[3] = 0.0;
-      } else {
-        FullRooTracker->EvtVtx[0] = vtx->Pos(0)->X();
-        FullRooTracker->EvtVtx[1] = vtx->Pos(0)->Y();
-        FullRooTracker->EvtVtx[2] = vtx->Pos(0)->Z();
-        FullRooTracker->EvtVtx[3] = vtx->Pos(0)->T();
-      }
-    }
-
-    //**************************************************
-    // StdHepN Particles
-
     if (NeutToRooTrackerOpts::verbosity > 3) {
       UDBInfo(
           "**********************************************************"
@@ -266,256 +1481,247 @@ int NeutToRooTracker(const char* InputFileDescriptor) {
           "**********************");
     }
 
-    outRooTracker->IsBound = vector->Ibound;
-
-    int saveInd = 0;
-    for (int partNum = 0; partNum < vector->Npart(); ++partNum) {
-      const NeutPart& part = (*vector->PartInfo(partNum));
-
-      if ((partNum == 1) && NeutToRooTrackerOpts::EmulateNuWro) {
-        // As in nuwro2rootracker partnum 1 should have P4 of the struck
-        // nucleon but the PDG of the target
-        outRooTracker->StdHepPdg[saveInd] =
-            Utils::MakeNuclearPDG(vector->TargetZ, vector->TargetA);
-        // Now save the struck nucleon properties
-        outRooTracker->StdHepP4[saveInd][kNStdHepIdxPx] =
-            part.fP.Px() * EUnitScaleFactor;
-        outRooTracker->StdHepP4[saveInd][kNStdHepIdxPy] =
-            part.fP.Py() * EUnitScaleFactor;
-        outRooTracker->StdHepP4[saveInd][kNStdHepIdxPz] =
-            part.fP.Pz() * EUnitScaleFactor;
-        outRooTracker->StdHepP4[saveInd][kNStdHepIdxE] =
-            part.fP.E() * EUnitScaleFactor;
-
-        outRooTracker->StruckNucleonPDG = part.fPID;
-
-        // Not implemented in NEUT
-        if (!NeutToRooTrackerOpts::LiteMode) {
-          (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxX];
-          (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxY];
-          (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxZ];
-          (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxT];
-          (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPx];
-          (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPy];
-          (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPz];
-          (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxE];
-        }
-        ++saveInd;
-        continue;
-      } else if (partNum == 1) {
-        // As in TNeutOutput, to emulate neutgeom
-        // StdHepX[1] is the target
-        outRooTracker->StdHepPdg[saveInd] =
-            Utils::MakeNuclearPDG(vector->TargetZ, vector->TargetA);
-        outRooTracker->StdHepP4[saveInd][kNStdHepIdxE] = vector->TargetA;
-        // Now incremebent the saveInd to save the struck nucleon properties
-        // but don't continue
-        // Not implemented in NEUT
-        if (!NeutToRooTrackerOpts::LiteMode) {
-          (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxX];
-          (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxY];
-          (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxZ];
-          (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxT];
-          (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPx];
-          (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPy];
-          (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPz];
-          (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxE];
-        }
-        ++saveInd;
-      }
-
-      outRooTracker->StdHepPdg[saveInd] = part.fPID;
-
-      switch (part.fStatus) {
-        case -1: {  // Initial state
-          outRooTracker->StdHepStatus[saveInd] = 0;
-          break;
-        }
-        case 0: {  // Good
-          if (part.fIsAlive == 1) {
-            outRooTracker->StdHepStatus[saveInd] = 1;
-          } else {  // But also bad!?
-            outRooTracker->StdHepStatus[saveInd] = 2;
-            if (NeutToRooTrackerOpts::SkipNonFS) {
-              UDBVerbose(
-                  "Not saving particle status ("
-                  << part.fStatus << ":\"" << NEUTStatusCodes[part.fStatus]
-                  << "\") as it was not 'IsAlive' in event: " << entryNum);
-              continue;
-            }
-          }
-          break;
-        }
-        case 2: {  // Escaped detector == Good
-          if (part.fIsAlive == 1) {
-            outRooTracker->StdHepStatus[saveInd] = 1;
-            UDBWarn("Found NEUT status 2:\""
-                    << NEUTStatusCodes[part.fStatus]
-                    << "\" which was marked as "
-                       "IsAlive. (PDG:"
-                    << outRooTracker->StdHepPdg[saveInd]
-                    << ") in event: " << entryNum);
-          } else {  // But also bad.
-            outRooTracker->StdHepStatus[saveInd] = 2;
-            if (NeutToRooTrackerOpts::SkipNonFS) {
-              UDBVerbose("Not saving particle status("
-                         << part.fStatus << ":\""
-                         << NEUTStatusCodes[part.fStatus]
-                         << "\") as it was not 'IsAlive'. (PDG:"
-                         << outRooTracker->StdHepPdg[saveInd]
-                         << ") in event: " << entryNum);
-              continue;
-            }
-          }
-          break;
-        }
-        default: {
-          UDBWarn("Found unexpected neut fStatus code: "
-                  << part.fStatus << ":\"" << NEUTStatusCodes[part.fStatus]
-                  << "\" in event: " << entryNum);
-          outRooTracker->StdHepStatus[saveInd] = part.fStatus;
-          if (NeutToRooTrackerOpts::SkipNonFS) {
-            continue;
-          }
-        }
-      }
-      // TODO Check MEC events
-      if ((!NeutToRooTrackerOpts::EmulateNuWro) && (partNum == 1) &&
-          (part.fStatus == -1)) {
-        outRooTracker->StdHepStatus[saveInd] =
-            11;  // To sync with GENIE code for
-        // Struck Nucleon.
+    for (OutputSink* sink : Sinks) {
+      if ((rtncode = sink->Fill(vector, vtx, Input->File, Input->EntryNum))) {
+        break;
       }
+    }
 
-      outRooTracker->StdHepP4[saveInd][kNStdHepIdxPx] =
-          part.fP.Px() * EUnitScaleFactor;
-      outRooTracker->StdHepP4[saveInd][kNStdHepIdxPy] =
-          part.fP.Py() * EUnitScaleFactor;
-      outRooTracker->StdHepP4[saveInd][kNStdHepIdxPz] =
-          part.fP.Pz() * EUnitScaleFactor;
-      outRooTracker->StdHepP4[saveInd][kNStdHepIdxE] =
-          part.fP.E() * EUnitScaleFactor;
-
-      // Not implemented in NEUT
-      if (!NeutToRooTrackerOpts::LiteMode) {
-        (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxX];
-        (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxY];
-        (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxZ];
-        (void)FullRooTracker->StdHepX4[saveInd][kNStdHepIdxT];
-        (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPx];
-        (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPy];
-        (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxPz];
-        (void)FullRooTracker->StdHepPolz[saveInd][kNStdHepIdxE];
+    if (NeutToRooTrackerOpts::TimeFirstEvent && (!TimedFirstEvent)) {
+      TimedFirstEvent = true;
+      if (!FirstEventTimed.exchange(true)) {
+        std::stringstream WallClock("");
+        WallClock << std::fixed << std::setprecision(3) << GetWallClockTime();
+        UDBLog("Time to first event: "
+               << GetSecondsSinceProcessStart()
+               << " s since process start, RSS: "
+               << (MemoryBudget::GetCurrentRSS() >> 20)
+               << " MB, wall clock: " << WallClock.str() << " s.");
       }
-      saveInd++;
-    }  // end for(int partNum = 0; partNum < vector->Npart(); ++partNum)
+    }
+  }
+  if (NeutToRooTrackerOpts::ModeIgnores.size()) {
+    UDBLog("Ignored " << IgnoredEntries << " entries based on "
+                                           "interaction mode. ");
+  }
 
-    outRooTracker->StdHepN = saveInd;
+  if (MemMonitor && (!rtncode)) {
+    MemMonitor->Check();
+  }
 
-    UDBVerbose("(Interation Mode: " << vector->Mode << ")");
-    for (int it = 0; it < outRooTracker->StdHepN; ++it) {
-      UDBVerbose(((it > 0) ? "Particle:" : "Incoming Neutrino:")
-                 << " " << it << "/" << outRooTracker->StdHepN
-                 << "(VectNPart:" << vector->Npart() << ")"
-                 << "\n\tStdHEPPDG: " << outRooTracker->StdHepPdg[it]
-                 << "\n\tStdHEPStatus: " << outRooTracker->StdHepStatus[it]
-                 << "\n\tStdHEPP4: "
-                 << Utils::PrintArray(outRooTracker->StdHepP4[it]));
+  for (OutputSink* sink : Sinks) {
+    if (!rtncode) {
+      sink->Close();
     }
+    Stats.NWritten += sink->GetNFilled();
+    delete sink;
+  }
 
-    if (!NeutToRooTrackerOpts::LiteMode) {
-      //**************************************************
-      // NEUT VCWork Particles
-      FullRooTracker->NEnvc = vector->Npart();
-      for (int partNum = 0; partNum < FullRooTracker->NEnvc; ++partNum) {
-        const NeutPart& part = (*vector->PartInfo(partNum));
+  if (MemMonitor) {
+    if (!rtncode) {
+      MemMonitor->Report();
+    }
+    delete MemMonitor;
+  }
+  delete Input;
+  return rtncode;
+}
 
-        FullRooTracker->NEpvc[partNum][0] = part.fP.Px() * EUnitScaleFactor;
-        FullRooTracker->NEpvc[partNum][1] = part.fP.Py() * EUnitScaleFactor;
-        FullRooTracker->NEpvc[partNum][2] = part.fP.Pz() * EUnitScaleFactor;
-        FullRooTracker->NEipvc[partNum] = part.fPID;
-        FullRooTracker->NEiorgvc[partNum] = 0;
-        FullRooTracker->NEiflgvc[partNum] = part.fStatus;
-        FullRooTracker->NEicrnvc[partNum] = part.fIsAlive ? 1 : 0;
-      }
+///A single conversion read from a manifest file.
+struct ManifestJob {
+  std::string Input;
+  SinkOpts Opts;
+  int RtnCode;
+  ConversionStats Stats;
+  double Seconds;
+};
 
-      //**************************************************
-      // NEUT Pion FSI interaction history
-      FullRooTracker->NEnvert = vector->NfsiVert();
-
-      for (int FSIVertNum = 0; FSIVertNum < FullRooTracker->NEnvert;
-           ++FSIVertNum) {
-        const NeutFsiVert& fsiVert = (*vector->FsiVertInfo(FSIVertNum));
-        FullRooTracker->NEposvert[FSIVertNum][0] = fsiVert.fPos.X();
-        FullRooTracker->NEposvert[FSIVertNum][1] = fsiVert.fPos.Y();
-        FullRooTracker->NEposvert[FSIVertNum][2] = fsiVert.fPos.Z();
-        FullRooTracker->NEiflgvert[FSIVertNum] = fsiVert.fVertID;
-      }
+///\brief Reads the jobs from a manifest file.
+///
+///\details Each line is <tt><input descriptor> <output file> [flags]</tt>,
+/// where the flags are added to those given on the command line, see
+/// SinkOpts::SetFlags. Empty lines and lines starting with \c # are skipped.
+bool ReadManifest(std::string const& FName, std::vector<ManifestJob>& Jobs) {
+  std::ifstream ifs(FName.c_str());
+  if (!ifs.is_open()) {
+    UDBError("Couldn't open manifest file: " << FName);
+    return false;
+  }
 
-      FullRooTracker->NEnvcvert = vector->NfsiPart();
-      for (int FSIPartNum = 0; FSIPartNum < FullRooTracker->NEnvcvert;
-           ++FSIPartNum) {
-        const NeutFsiPart& fsiPart = (*vector->FsiPartInfo(FSIPartNum));
-
-        FullRooTracker->NEdirvert[FSIPartNum][0] = fsiPart.fDir.X();
-        FullRooTracker->NEdirvert[FSIPartNum][1] = fsiPart.fDir.Y();
-        FullRooTracker->NEdirvert[FSIPartNum][2] = fsiPart.fDir.Z();
-        FullRooTracker->NEabspvert[FSIPartNum] =
-            fsiPart.fMomLab * EUnitScaleFactor;
-        FullRooTracker->NEabstpvert[FSIPartNum] =
-            fsiPart.fMomNuc * EUnitScaleFactor;
-        FullRooTracker->NEipvert[FSIPartNum] = fsiPart.fPID;
-        FullRooTracker->NEiverti[FSIPartNum] = fsiPart.fVertStart;
-        FullRooTracker->NEivertf[FSIPartNum] = fsiPart.fVertEnd;
-      }
+  std::string line;
+  long LineNumber = 0;
+  while (std::getline(ifs, line)) {
+    LineNumber++;
+    std::istringstream ss(line);
+    std::string Input, Output, Flags, Extra;
+    if (!(ss >> Input) || (Input[0] == '#')) {
+      continue;
+    }
+    ss >> Output >> Flags >> Extra;
+
+    ManifestJob job;
+    job.Input = Input;
+    job.Opts = NeutToRooTrackerOpts::GetMainSinkOpts();
+    job.Opts.OutFName = Output;
+    job.RtnCode = 0;
+    job.Seconds = 0;
+    if ((!Output.length()) || Extra.length() || (Input == "-") ||
+        (!job.Opts.SetFlags(Flags))) {
+      UDBError(FName << ":" << LineNumber << ": Could not parse manifest "
+                                               "entry: \""
+                     << line << "\"");
+      return false;
+    }
+    Jobs.push_back(job);
+  }
 
-#ifdef HAVE_NUCLEON_FSI_TRACKING
+  if (!Jobs.size()) {
+    UDBError("Found no jobs in manifest file: " << FName);
+    return false;
+  }
+  return true;
+}
 
-      //**************************************************
-      // NEUT Nucleon FSI interaction history
-      FullRooTracker->NFnvert = vector->NnucFsiVert();
-      for (int NucFSIPartNum = 0; NucFSIPartNum < FullRooTracker->NFnvert;
-           ++NucFSIPartNum) {
-        const NeutNucFsiVert& nucFSIPart =
-            (*vector->NucFsiVertInfo(NucFSIPartNum));
-
-        FullRooTracker->NFiflag[NucFSIPartNum] = nucFSIPart.fVertFlag;
-        FullRooTracker->NFx[NucFSIPartNum] = nucFSIPart.fPos.X();
-        FullRooTracker->NFy[NucFSIPartNum] = nucFSIPart.fPos.Y();
-        FullRooTracker->NFz[NucFSIPartNum] = nucFSIPart.fPos.Z();
-        FullRooTracker->NFpx[NucFSIPartNum] = nucFSIPart.fMom.X();
-        FullRooTracker->NFpy[NucFSIPartNum] = nucFSIPart.fMom.X();
-        FullRooTracker->NFpz[NucFSIPartNum] = nucFSIPart.fMom.X();
-        FullRooTracker->NFe[NucFSIPartNum] = nucFSIPart.fMom.X();
-        FullRooTracker->NFfirststep[NucFSIPartNum] = nucFSIPart.fVertFirstStep;
-      }
+///\brief Runs each job in a manifest file through a pool of worker threads
+/// and writes a summary at the end.
+///
+///\details Returns non-zero if any job failed.
+///\brief A stream buffer that collects the output of each thread and passes
+/// it on to \c Target a line at a time, under a lock.
+///
+///\details Installed on \c std::cout and \c std::cerr while manifest jobs
+/// run, so that the log lines of concurrent conversions never interleave
+/// part way through. Output is passed on when the stream is flushed, e.g. by
+/// the \c std::endl ending each log message, up to the last complete line.
+class LineLockedBuf : public std::streambuf {
+public:
+  LineLockedBuf(std::streambuf* Target, std::mutex& Mutex)
+      : fTarget(Target), fMutex(Mutex) {}
+
+  ///Passes on this thread's output, including any incomplete line.
+  void FlushThread() { Write(true); }
+
+protected:
+  int_type overflow(int_type c) {
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      GetBuffer() += traits_type::to_char_type(c);
+    }
+    return traits_type::not_eof(c);
+  }
+  std::streamsize xsputn(char const* str, std::streamsize n) {
+    GetBuffer().append(str, size_t(n));
+    return n;
+  }
+  int sync() {
+    Write(false);
+    return 0;
+  }
 
-      FullRooTracker->NFnstep = vector->NnucFsiStep();
-      for (int NucFSIStepNum = 0; NucFSIStepNum < FullRooTracker->NFnstep;
-           ++NucFSIStepNum) {
-        const NeutNucFsiStep& nucFSIStep =
-            (*vector->NucFsiStepInfo(NucFSIStepNum));
-        FullRooTracker->NFecms2[NucFSIStepNum] = nucFSIStep.fECMS2;
-        FullRooTracker->NFProb[NucFSIStepNum] = nucFSIStep.fProb;
-      }
+private:
+  std::string& GetBuffer() {
+    // Each thread buffers the output to each stream separately.
+    static thread_local std::map<LineLockedBuf const*, std::string> Buffers;
+    return Buffers[this];
+  }
+  void Write(bool Partial) {
+    std::string& Buffer = GetBuffer();
+    size_t n = Buffer.size();
+    if (!Partial) {
+      size_t LastLine = Buffer.rfind('\n');
+      n = (LastLine == std::string::npos) ? 0 : (LastLine + 1);
+    }
+    if (!n) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fTarget->sputn(Buffer.data(), std::streamsize(n));
+      fTarget->pubsync();
+    }
+    Buffer.erase(0, n);
+  }
 
-#endif
-    }  // end if(!NeutToRooTrackerOpts::LiteMode)
+  std::streambuf* fTarget;
+  std::mutex& fMutex;
+};
 
-    rooTrackerTree->Fill();
-    FilledEntries++;
-    UDBVerbose("*****************Filled*****************\n");
-    outRooTracker->Reset();
+int RunManifest(std::string const& FName, int NWorkers) {
+  std::vector<ManifestJob> Jobs;
+  if (!ReadManifest(FName, Jobs)) {
+    return 1;
   }
-  UDBLog("Wrote " << FilledEntries << " events to disk.");
-  if (NeutToRooTrackerOpts::ModeIgnores.size()) {
-    UDBLog("Ignored " << IgnoredEntries << " entries based on "
-                                           "interaction mode. ");
+  NWorkers = std::max(std::min(NWorkers, int(Jobs.size())), 1);
+  UDBLog("Running " << Jobs.size() << " conversions from " << FName << " on "
+                    << NWorkers << " worker threads.");
+
+  ROOT::EnableThreadSafety();
+
+  TStopwatch ManifestTimer;
+  ManifestTimer.Start();
+
+  // The log macros write through the standard streams, which are not safe to
+  // share between the workers.
+  std::mutex LogMutex;
+  LineLockedBuf OutBuf(std::cout.rdbuf(), LogMutex);
+  LineLockedBuf ErrBuf(std::cerr.rdbuf(), LogMutex);
+  std::streambuf* OutTarget = std::cout.rdbuf(&OutBuf);
+  std::streambuf* ErrTarget = std::cerr.rdbuf(&ErrBuf);
+
+  std::atomic<size_t> NextJob(0);
+  std::vector<std::thread> Workers;
+  for (int w = 0; w < NWorkers; ++w) {
+    Workers.push_back(std::thread([&]() {
+      for (size_t j = NextJob++; j < Jobs.size(); j = NextJob++) {
+        TStopwatch JobTimer;
+        JobTimer.Start();
+        Jobs[j].RtnCode = NeutToRooTracker(Jobs[j].Input.c_str(),
+                                           {Jobs[j].Opts}, Jobs[j].Stats);
+        JobTimer.Stop();
+        Jobs[j].Seconds = JobTimer.RealTime();
+        OutBuf.FlushThread();
+        ErrBuf.FlushThread();
+      }
+    }));
+  }
+  for (std::thread& worker : Workers) {
+    worker.join();
+  }
+  std::cout.rdbuf(OutTarget);
+  std::cerr.rdbuf(ErrTarget);
+  ManifestTimer.Stop();
+
+  ConversionStats Total;
+  size_t NFailed = 0;
+  for (ManifestJob const& job : Jobs) {
+    Total.NRead += job.Stats.NRead;
+    Total.NWritten += job.Stats.NWritten;
+    if (job.RtnCode) {
+      NFailed++;
+    }
   }
 
-  rooTrackerTree->Write();
-  outFile->Close();
-  return 0;
+  double Seconds = ManifestTimer.RealTime();
+  UDBLog("Manifest summary:"
+         << "\n\tJobs            : " << Jobs.size() << " ("
+         << (Jobs.size() - NFailed) << " succeeded, " << NFailed << " failed)"
+         << "\n\tWorkers         : " << NWorkers
+         << "\n\tEvents read     : " << Total.NRead
+         << "\n\tEvents written  : " << Total.NWritten
+         << "\n\tWall time       : " << Seconds << " s"
+         << "\n\tThroughput      : "
+         << (Seconds > 0 ? (Total.NRead / Seconds) : 0) << " events/s");
+  int rtncode = 0;
+  for (ManifestJob const& job : Jobs) {
+    if (job.RtnCode) {
+      UDBError("\tFailed (" << job.RtnCode << "): " << job.Input << " -> "
+                             << job.Opts.OutFName << " after " << job.Seconds
+                             << " s");
+      if (!rtncode) {
+        rtncode = job.RtnCode;
+      }
+    }
+  }
+  return rtncode;
 }
 
 namespace NeutToRooTrackerOpts {
@@ -529,7 +1735,7 @@ void SetOpts() {
                     InpFDescript = opt;
                     return true;
                   },
-                  true, []() {}, "<TChain::Add descriptor>");
+                  false, []() {}, "<TChain::Add descriptor|-|stream:<file>>");
 
   CLIArgs::AddOpt("-o", "--output-file", true,
                   [&](std::string const& opt) -> bool {
@@ -640,6 +1846,251 @@ void SetOpts() {
         return false;
       },
       false, []() {}, "<int,int,...> NEUT modes to save output from.");
+
+  CLIArgs::AddOpt(
+      "-M", "--max-memory", true,
+      [&](std::string const& opt) -> bool {
+        long vbhold;
+        if ((Utils::str2int(vbhold, opt.c_str()) == Utils::STRINT_SUCCESS) &&
+            (vbhold > 0)) {
+          std::cout << "\t--Keeping resident memory under " << vbhold
+                    << " MB." << std::endl;
+          MaxMemoryMB = vbhold;
+          return true;
+        }
+        return false;
+      },
+      false, [&]() { MaxMemoryMB = 0; },
+      "<MB> Resident memory budget {default=unlimited}");
+
+  CLIArgs::AddOpt(
+      "-X", "--extra-outputs", true,
+      [&](std::string const& opt) -> bool {
+        for (auto const& sinkspec : Utils::SplitStringByDelim(opt, ",")) {
+          std::vector<std::string> fileflags =
+              Utils::SplitStringByDelim(sinkspec, ":");
+          SinkOpts sink;
+          if ((fileflags.size() < 1) || (fileflags.size() > 2) ||
+              ((fileflags.size() == 2) && !sink.SetFlags(fileflags[1]))) {
+            std::cout << "[ERROR]: Could not parse extra output: \""
+                      << sinkspec << "\"" << std::endl;
+            return false;
+          }
+          sink.OutFName = fileflags[0];
+          std::cout << "\t--Also writing to File: " << sink.OutFName
+                    << ((fileflags.size() == 2) ? " with flags: -" : "")
+                    << ((fileflags.size() == 2) ? fileflags[1] : "")
+                    << std::endl;
+          ExtraSinks.push_back(sink);
+        }
+        return true;
+      },
+      false, []() {}, "<File Name[:flags],...> flags: [OGbLES]");
+
+  CLIArgs::AddOpt("-T", "--topology-skim", true,
+                  [&](std::string const& opt) -> bool {
+                    std::cout << "\t--Only writing events passing: " << opt
+                              << std::endl;
+                    return Skim.Parse(opt);
+                  },
+                  false, []() {},
+                  "<predicate,...> e.g. CC0pi,CC1pip&p@500>=1");
+
+  CLIArgs::AddOpt("-C", "--compact-vcwork", false,
+                  [&](std::string const& opt) -> bool {
+                    std::cout << "\t--Writing compact NEUT VCWork block."
+                              << std::endl;
+                    Schema.CompactVCWork = true;
+                    return true;
+                  },
+                  false, [&]() { Schema.CompactVCWork = false; },
+                  "Don't duplicate StdHep in the NEUT VCWork block.");
+
+  CLIArgs::AddOpt("-F", "--file-metadata", false,
+                  [&](std::string const& opt) -> bool {
+                    std::cout << "\t--Writing per-file constants to the "
+                                 "nRooTrackerMeta tree."
+                              << std::endl;
+                    Schema.FileMetadata = true;
+                    return true;
+                  },
+                  false, [&]() { Schema.FileMetadata = false; },
+                  "Write per-file constants to a metadata tree.");
+
+  CLIArgs::AddOpt(
+      "-P", "--precision", true,
+      [&](std::string const& opt) -> bool {
+        for (auto const& grpspec : Utils::SplitStringByDelim(opt, ",")) {
+          std::vector<std::string> grppol =
+              Utils::SplitStringByDelim(grpspec, "=");
+          NRooTrackerPrecision prec;
+          if ((grppol.size() != 2) || !prec.Parse(grppol[1])) {
+            std::cout << "[ERROR]: Could not parse precision policy: \""
+                      << grpspec << "\"" << std::endl;
+            return false;
+          }
+          if ((grppol[0] == "P4") || (grppol[0] == "all")) {
+            Schema.P4Precision = prec;
+          }
+          if ((grppol[0] == "X4") || (grppol[0] == "all")) {
+            Schema.X4Precision = prec;
+          }
+          if ((grppol[0] == "Polz") || (grppol[0] == "all")) {
+            Schema.PolzPrecision = prec;
+          }
+          if ((grppol[0] != "P4") && (grppol[0] != "X4") &&
+              (grppol[0] != "Polz") && (grppol[0] != "all")) {
+            std::cout << "[ERROR]: Unknown branch group: \"" << grppol[0]
+                      << "\"" << std::endl;
+            return false;
+          }
+          std::cout << "\t--Storing " << grppol[0] << " branches as "
+                    << grppol[1] << std::endl;
+        }
+        return true;
+      },
+      false, []() {},
+      "<group=policy,...> group: P4|X4|Polz|all, policy: "
+      "double|float|trunc:<min>:<max>:<nbits> {default=all=double}");
+
+  CLIArgs::AddOpt(
+      "-m", "--split-by-mode", true,
+      [&](std::string const& opt) -> bool {
+        SplitByMode = true;
+        if (opt == "all") {
+          std::cout << "\t--Writing each NEUT mode to its own output file."
+                    << std::endl;
+          return true;
+        }
+        for (auto const& grpspec : Utils::SplitStringByDelim(opt, ",")) {
+          std::vector<std::string> grpmodes =
+              Utils::SplitStringByDelim(grpspec, "=");
+          std::vector<int> modes;
+          if (grpmodes.size() == 2) {
+            modes = Utils::StringVToIntV(
+                Utils::SplitStringByDelim(grpmodes[1], "+"));
+          }
+          if ((grpmodes.size() != 2) || (!grpmodes[0].length()) ||
+              (!modes.size())) {
+            std::cout << "[ERROR]: Could not parse mode group: \"" << grpspec
+                      << "\"" << std::endl;
+            return false;
+          }
+          std::cout << "\t--Writing NEUT modes " << grpmodes[1]
+                    << " to output group: " << grpmodes[0] << std::endl;
+          for (int const& mode : modes) {
+            ModeGroups[mode] = grpmodes[0];
+          }
+        }
+        return true;
+      },
+      false, []() {},
+      "<all|group=mode+mode+...,...> e.g. CCQE=1,CC1pi=11+12+13");
+
+  CLIArgs::AddOpt("-H", "--fsi-friend", true,
+                  [&](std::string const& opt) -> bool {
+                    if ((opt != "same") && (opt != "separate")) {
+                      return false;
+                    }
+                    std::cout << "\t--Writing FSI history to the "
+                              << NRooTrackerVtx::kFSITreeName
+                              << " friend tree in the " << opt << " file."
+                              << std::endl;
+                    Schema.FSIFriend = true;
+                    FSIFriendSeparateFile = (opt == "separate");
+                    return true;
+                  },
+                  false, [&]() { Schema.FSIFriend = false; },
+                  "<same|separate> Write FSI history to a friend tree.");
+
+  CLIArgs::AddOpt(
+      "-p", "--sample", true,
+      [&](std::string const& opt) -> bool {
+        std::vector<std::string> sampspec =
+            Utils::SplitStringByDelim(opt, ":");
+        if ((sampspec.size() == 2) && (sampspec[0] == "every")) {
+          if ((Utils::str2int(SampleEvery, sampspec[1].c_str()) !=
+               Utils::STRINT_SUCCESS) ||
+              (SampleEvery < 1)) {
+            return false;
+          }
+          std::cout << "\t--Converting every " << SampleEvery
+                    << "th input entry." << std::endl;
+          return true;
+        }
+        if (((sampspec.size() == 2) || (sampspec.size() == 3)) &&
+            (sampspec[0] == "random")) {
+          char* end = nullptr;
+          SampleFraction = strtod(sampspec[1].c_str(), &end);
+          if (sampspec[1].empty() || (*end != '\0') || (SampleFraction <= 0) ||
+              (SampleFraction > 1)) {
+            return false;
+          }
+          int seed = SampleSeed;
+          if ((sampspec.size() == 3) &&
+              ((Utils::str2int(seed, sampspec[2].c_str()) !=
+                Utils::STRINT_SUCCESS) ||
+               (seed < 1))) {
+            return false;
+          }
+          SampleSeed = seed;
+          std::cout << "\t--Converting a random " << SampleFraction
+                    << " of the input entries with seed " << SampleSeed
+                    << "." << std::endl;
+          return true;
+        }
+        return false;
+      },
+      false, []() {},
+      "<every:<k>|random:<fraction>[:<seed>]> Convert a sample of the input.");
+
+  CLIArgs::AddOpt("-J", "--manifest", true,
+                  [&](std::string const& opt) -> bool {
+                    std::cout << "\t--Running the conversions listed in: "
+                              << opt << std::endl;
+                    ManifestFName = opt;
+                    return true;
+                  },
+                  false, []() {},
+                  "<File Name> lines of: <input> <output> [flags: OGbLES]");
+
+  CLIArgs::AddOpt(
+      "-j", "--jobs", true,
+      [&](std::string const& opt) -> bool {
+        int vbhold;
+        if ((Utils::str2int(vbhold, opt.c_str()) == Utils::STRINT_SUCCESS) &&
+            (vbhold > 0)) {
+          std::cout << "\t--Running manifest jobs on " << vbhold
+                    << " worker threads." << std::endl;
+          NManifestWorkers = vbhold;
+          return true;
+        }
+        return false;
+      },
+      false,
+      [&]() {
+        NManifestWorkers = std::max(int(std::thread::hardware_concurrency()), 1);
+      },
+      "<N> Manifest worker threads {default=number of cores}");
+
+  CLIArgs::AddOpt("-e", "--event-list", true,
+                  [&](std::string const& opt) -> bool {
+                    std::cout << "\t--Only converting the events listed in: "
+                              << opt << std::endl;
+                    EventListFName = opt;
+                    return true;
+                  },
+                  false, []() {},
+                  "<File Name> lines of: <input file> <EventNo|@entry>");
+
+  CLIArgs::AddOpt("-t", "--time-first-event", false,
+                  [&](std::string const& opt) -> bool {
+                    std::cout << "\t--Timing the first event." << std::endl;
+                    TimeFirstEvent = true;
+                    return true;
+                  },
+                  false, [&]() { TimeFirstEvent = false; },
+                  "Log the time to the first converted event.");
 }
 }
 
@@ -655,9 +2106,52 @@ int main(int argc, char const* argv[]) {
   UDBSetDebuggingLevel(NeutToRooTrackerOpts::verbosity);
   UDBSetInfoLevel(NeutToRooTrackerOpts::verbosity);
 
+  if (NeutToRooTrackerOpts::ManifestFName.length()) {
+    if (NeutToRooTrackerOpts::InpFDescript.length() ||
+        NeutToRooTrackerOpts::ExtraSinks.size() ||
+        NeutToRooTrackerOpts::EventListFName.length()) {
+      UDBError("-i, -X and -e cannot be used with a manifest (-J).");
+      CLIArgs::SayRunLike();
+      return 1;
+    }
+    if ((NeutToRooTrackerOpts::MaxMemoryMB > 0) &&
+        (NeutToRooTrackerOpts::NManifestWorkers > 1)) {
+      UDBError("A memory budget (-M) can only be used with a single manifest "
+               "worker (-j 1).");
+      CLIArgs::SayRunLike();
+      return 1;
+    }
+    int rtncode = RunManifest(NeutToRooTrackerOpts::ManifestFName,
+                              NeutToRooTrackerOpts::NManifestWorkers);
+    UDBTearDown();
+    return rtncode;
+  }
+
+  if (NeutToRooTrackerOpts::EventListFName.length()) {
+    if (NeutToRooTrackerOpts::InpFDescript.length() ||
+        NeutToRooTrackerOpts::SampleEvery ||
+        (NeutToRooTrackerOpts::SampleFraction > 0)) {
+      UDBError("-i and -p cannot be used with an event list (-e).");
+      CLIArgs::SayRunLike();
+      return 1;
+    }
+  } else if (!NeutToRooTrackerOpts::InpFDescript.length()) {
+    UDBError(
+        "An input file descriptor (-i), an event list (-e) or a manifest "
+        "(-J) is required.");
+    CLIArgs::SayRunLike();
+    return 1;
+  }
+
+  std::vector<SinkOpts> SinkList;
+  SinkList.push_back(NeutToRooTrackerOpts::GetMainSinkOpts());
+  SinkList.insert(SinkList.end(), NeutToRooTrackerOpts::ExtraSinks.begin(),
+                  NeutToRooTrackerOpts::ExtraSinks.end());
+
+  ConversionStats Stats;
   int rtncode = 0;
-  if ((rtncode =
-           NeutToRooTracker(NeutToRooTrackerOpts::InpFDescript.c_str()))) {
+  if ((rtncode = NeutToRooTracker(NeutToRooTrackerOpts::InpFDescript.c_str(),
+                                  SinkList, Stats))) {
     CLIArgs::SayRunLike();
   }
 
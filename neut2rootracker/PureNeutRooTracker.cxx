@@ -1,5 +1,11 @@
+#include <cstdlib>
 #include <sstream>
 
+#include "TChain.h"
+#include "TDirectory.h"
+#include "TError.h"
+#include "TObjArray.h"
+
 #include "LUtils/Utils.hxx"
 
 #include "PureNeutRooTracker.hxx"
@@ -17,6 +23,76 @@ char const * NEUTStatusCodes[] = {
   "FORWARD (ELASTIC-LIKE) SCATTER"
 };
 
+namespace {
+void SetAddressIfPresent(TTree* tree, char const* name, void* addr){
+  if(tree->GetBranch(name)){
+    tree->SetBranchAddress(name, addr);
+  }
+}
+
+bool ParseDouble(std::string const &str, Double_t &val){
+  char *end = nullptr;
+  val = strtod(str.c_str(), &end);
+  return str.size() && ((*end) == '\0');
+}
+}
+
+NRooTrackerPrecision::NRooTrackerPrecision() : Pol(kDouble), Min(0), Max(0),
+  NBits(32) {}
+
+bool NRooTrackerPrecision::Parse(std::string const &spec){
+  if(spec == "double"){
+    Pol = kDouble;
+    return true;
+  }
+  if(spec == "float"){
+    Pol = kFloat;
+    return true;
+  }
+
+  std::vector<std::string> parts = Utils::SplitStringByDelim(spec,":");
+  if((parts.size() != 4) || (parts[0] != "trunc")){
+    return false;
+  }
+  if(!ParseDouble(parts[1],Min) || !ParseDouble(parts[2],Max) ||
+     (Utils::str2int(NBits,parts[3].c_str()) != Utils::STRINT_SUCCESS)){
+    return false;
+  }
+  if((Min >= Max) || (NBits < 2) || (NBits > 32)){
+    return false;
+  }
+  Pol = kTruncated;
+  return true;
+}
+
+std::string NRooTrackerPrecision::LeafType() const {
+  switch(Pol){
+    case kFloat: { return "d"; }
+    case kTruncated: {
+      std::stringstream ss("");
+      ss.precision(12);
+      ss << "d[" << Min << "," << Max << "," << NBits << "]";
+      return ss.str();
+    }
+    default: { return "D"; }
+  }
+}
+
+Double_t NRooTrackerPrecision::Round(Double_t val) const {
+  switch(Pol){
+    case kFloat: { return Double_t(Float_t(val)); }
+    case kTruncated: {
+      // Mirrors the Double32_t range packing in TBufferFile::WriteDouble32
+      Double_t factor = ((NBits < 32) ? Double_t(1u<<NBits) : 0xffffffff)/
+        (Max-Min);
+      Double_t clamped = (val < Min) ? Min : ((val > Max) ? Max : val);
+      UInt_t packed = UInt_t(0.5 + factor*(clamped-Min));
+      return Double_t(packed)/factor + Min;
+    }
+    default: { return val; }
+  }
+}
+
 NRooTrackerVtx::NRooTrackerVtx(){
   EvtCode = new TObjString("");
   StdHepPdg = new Int_t[kNStdHepNPmax];
@@ -30,6 +106,8 @@ NRooTrackerVtx::NRooTrackerVtx(){
   NEiorgvc = new Int_t[kNEmaxvc];
   NEiflgvc = new Int_t[kNEmaxvc];
   NEicrnvc = new Int_t[kNEmaxvc];
+  NEstdhepvc = new Int_t[kNEmaxvc];
+  NEipvcx = new Int_t[kNEmaxvc];
 
   NEiflgvert = new Int_t[kNEmaxvert];
 
@@ -67,6 +145,8 @@ NRooTrackerVtx::~NRooTrackerVtx(){
   if(NEiorgvc) { delete [] NEiorgvc; }
   if(NEiflgvc) { delete [] NEiflgvc; }
   if(NEicrnvc) { delete [] NEicrnvc; }
+  if(NEstdhepvc) { delete [] NEstdhepvc; }
+  if(NEipvcx) { delete [] NEipvcx; }
   if(NEiflgvert) { delete [] NEiflgvert; }
   if(NEabspvert) { delete [] NEabspvert; }
   if(NEabstpvert) { delete [] NEabstpvert; }
@@ -93,6 +173,7 @@ void NRooTrackerVtx::Reset(){
 
   (*EvtCode) = "";
   EvtNum = 0;
+  FileIndex = 0;
   EvtXSec = 0;
   EvtDXSec = 0;
   EvtWght = 0;
@@ -122,6 +203,11 @@ void NRooTrackerVtx::Reset(){
   Utils::ClearPointer(NEiorgvc,kNEmaxvc);
   Utils::ClearPointer(NEiflgvc,kNEmaxvc);
   Utils::ClearPointer(NEicrnvc,kNEmaxvc);
+  Utils::ClearPointer(NEstdhepvc,kNEmaxvc);
+
+  NEnvcx = 0;
+  Utils::ClearPointer(NEipvcx,kNEmaxvc);
+  Utils::ClearArray2D(NEpvcx);
 
   NEcrsx = 0;
   NEcrsy = 0;
@@ -162,36 +248,41 @@ void NRooTrackerVtx::Reset(){
 
 void NRooTrackerVtx::AddBranches(TTree* &tree,
   bool SaveIsBound,
-  bool SaveStruckNucleonPDG){
+  bool SaveStruckNucleonPDG,
+  NRooTrackerSchema const &schema){
 
   std::string NStdHepNPmaxstr = Utils::int2str(kNStdHepNPmax);
   std::string NEmaxvcstr = Utils::int2str(kNEmaxvc);
-  std::string NEmaxvertstr = Utils::int2str(kNEmaxvert);
-  std::string NEmaxvertpstr = Utils::int2str(kNEmaxvertp);
-
-#ifdef HAVE_NUCLEON_FSI_TRACKING
-  std::string NFMaxNucleonVert = Utils::int2str(kNFMaxNucleonVert);
-  std::string NFMaxNucleonSteps = Utils::int2str(kNFMaxNucleonSteps);
-#endif
 
   tree->Branch("EvtCode", &EvtCode);
   tree->Branch("EvtNum", &EvtNum,"EvtNum/I");
   tree->Branch("EvtXSec", &EvtXSec,"EvtXSec/D");
   tree->Branch("EvtDXSec", &EvtDXSec,"EvtDXSec/D");
-  tree->Branch("EvtWght", &EvtWght,"EvtWght/D");
-  tree->Branch("EvtHistWght", &EvtHistWght,"EvtHistWght/D");
-  tree->Branch("NEntriesInFile", &NEntriesInFile, "NEntriesInFile/D");
+  if(schema.FileMetadata){
+    tree->Branch("FileIndex", &FileIndex,"FileIndex/I");
+    tree->SetAlias("EvtWght","nRooTrackerMeta.EvtWght");
+    tree->SetAlias("EvtHistWght","nRooTrackerMeta.EvtHistWght");
+    tree->SetAlias("NEntriesInFile","nRooTrackerMeta.NEntriesInFile");
+    tree->SetAlias("GeneratorName","nRooTrackerMeta.GeneratorName");
+  } else {
+    tree->Branch("EvtWght", &EvtWght,"EvtWght/D");
+    tree->Branch("EvtHistWght", &EvtHistWght,"EvtHistWght/D");
+    tree->Branch("NEntriesInFile", &NEntriesInFile, "NEntriesInFile/D");
+  }
   tree->Branch("EvtProb", &EvtProb,"EvtProb/D");
   tree->Branch("EvtVtx", EvtVtx,"EvtVtx[4]/D");
   tree->Branch("StdHepN", &StdHepN,"StdHepN/I");
   tree->Branch("StdHepPdg", StdHepPdg,"StdHepPdg[StdHepN]/I");
   tree->Branch("StdHepStatus", StdHepStatus,"StdHepStatus[StdHepN]/I");
   tree->Branch("StdHepX4", StdHepX4,
-    ("StdHepX4["+NStdHepNPmaxstr+"][4]/D").c_str());
+    ("StdHepX4["+NStdHepNPmaxstr+"][4]/"+
+      schema.X4Precision.LeafType()).c_str());
   tree->Branch("StdHepP4", StdHepP4,
-    ("StdHepP4["+NStdHepNPmaxstr+"][4]/D").c_str());
+    ("StdHepP4["+NStdHepNPmaxstr+"][4]/"+
+      schema.P4Precision.LeafType()).c_str());
   tree->Branch("StdHepPolz", StdHepPolz,
-    ("StdHepPolz["+NStdHepNPmaxstr+"][3]/D").c_str());
+    ("StdHepPolz["+NStdHepNPmaxstr+"][3]/"+
+      schema.PolzPrecision.LeafType()).c_str());
   tree->Branch("StdHepFd", StdHepFd,"StdHepFd[StdHepN]/I");
   tree->Branch("StdHepLd", StdHepLd,"StdHepLd[StdHepN]/I");
   tree->Branch("StdHepFm", StdHepFm,"StdHepFm[StdHepN]/I");
@@ -201,20 +292,157 @@ void NRooTrackerVtx::AddBranches(TTree* &tree,
   if(SaveStruckNucleonPDG){ tree->Branch("StruckNucleonPDG", &StruckNucleonPDG, "StruckNucleonPDG/I"); }
 
   tree->Branch("NEnvc", &NEnvc,"NEnvc/I");
-  tree->Branch("NEipvc", NEipvc,"NEipvc[NEnvc]/I");
-  tree->Branch("NEpvc", NEpvc,("NEpvc["+NEmaxvcstr+"][3]/F").c_str());
-  tree->Branch("NEiorgvc", NEiorgvc,"NEiorgvc[NEnvc]/I");
+  if(schema.CompactVCWork){
+    tree->Branch("NEstdhepvc", NEstdhepvc,"NEstdhepvc[NEnvc]/I");
+    tree->Branch("NEnvcx", &NEnvcx,"NEnvcx/I");
+    tree->Branch("NEipvcx", NEipvcx,"NEipvcx[NEnvcx]/I");
+    tree->Branch("NEpvcx", NEpvcx,"NEpvcx[NEnvcx][3]/F");
+  } else {
+    tree->Branch("NEipvc", NEipvc,"NEipvc[NEnvc]/I");
+    tree->Branch("NEpvc", NEpvc,("NEpvc["+NEmaxvcstr+"][3]/F").c_str());
+    tree->Branch("NEiorgvc", NEiorgvc,"NEiorgvc[NEnvc]/I");
+  }
   tree->Branch("NEiflgvc", NEiflgvc,"NEiflgvc[NEnvc]/I");
   tree->Branch("NEicrnvc", NEicrnvc,"NEicrnvc[NEnvc]/I");
   tree->Branch("NEcrsx", &NEcrsx,"NEcrsx/F");
   tree->Branch("NEcrsy", &NEcrsy,"NEcrsy/F");
   tree->Branch("NEcrsz", &NEcrsz,"NEcrsz/F");
   tree->Branch("NEcrsphi", &NEcrsphi,"NEcrsphi/F");
+  if(!schema.FSIFriend){
+    AddFSIBranches(tree);
+  }
+  if(!schema.FileMetadata){
+    tree->Branch("GeneratorName", &GeneratorName);
+  }
+}
+
+void NRooTrackerVtx::RoundToPrecision(NRooTrackerSchema const &schema){
+  NRooTrackerVtxB::RoundToPrecision(schema);
+
+  if(schema.X4Precision.Pol != NRooTrackerPrecision::kDouble){
+    for(Int_t i = 0; i < StdHepN; ++i){
+      for(Int_t j = 0; j < 4; ++j){
+        StdHepX4[i][j] = schema.X4Precision.Round(StdHepX4[i][j]);
+      }
+    }
+  }
+  if(schema.PolzPrecision.Pol != NRooTrackerPrecision::kDouble){
+    for(Int_t i = 0; i < StdHepN; ++i){
+      for(Int_t j = 0; j < 3; ++j){
+        StdHepPolz[i][j] = schema.PolzPrecision.Round(StdHepPolz[i][j]);
+      }
+    }
+  }
+}
+
+void NRooTrackerVtx::SetBranchAddresses(TTree* tree){
+  SetAddressIfPresent(tree, "EvtCode", &EvtCode);
+  SetAddressIfPresent(tree, "EvtNum", &EvtNum);
+  SetAddressIfPresent(tree, "FileIndex", &FileIndex);
+  SetAddressIfPresent(tree, "EvtXSec", &EvtXSec);
+  SetAddressIfPresent(tree, "EvtDXSec", &EvtDXSec);
+  SetAddressIfPresent(tree, "EvtWght", &EvtWght);
+  SetAddressIfPresent(tree, "EvtHistWght", &EvtHistWght);
+  SetAddressIfPresent(tree, "NEntriesInFile", &NEntriesInFile);
+  SetAddressIfPresent(tree, "EvtProb", &EvtProb);
+  SetAddressIfPresent(tree, "EvtVtx", EvtVtx);
+  SetAddressIfPresent(tree, "StdHepN", &StdHepN);
+  SetAddressIfPresent(tree, "StdHepPdg", StdHepPdg);
+  SetAddressIfPresent(tree, "StdHepStatus", StdHepStatus);
+  SetAddressIfPresent(tree, "StdHepX4", StdHepX4);
+  SetAddressIfPresent(tree, "StdHepP4", StdHepP4);
+  SetAddressIfPresent(tree, "StdHepPolz", StdHepPolz);
+  SetAddressIfPresent(tree, "StdHepFd", StdHepFd);
+  SetAddressIfPresent(tree, "StdHepLd", StdHepLd);
+  SetAddressIfPresent(tree, "StdHepFm", StdHepFm);
+  SetAddressIfPresent(tree, "StdHepLm", StdHepLm);
+  SetAddressIfPresent(tree, "IsBound", &IsBound);
+  SetAddressIfPresent(tree, "StruckNucleonPDG", &StruckNucleonPDG);
+  SetAddressIfPresent(tree, "NEnvc", &NEnvc);
+  SetAddressIfPresent(tree, "NEipvc", NEipvc);
+  SetAddressIfPresent(tree, "NEpvc", NEpvc);
+  SetAddressIfPresent(tree, "NEiorgvc", NEiorgvc);
+  SetAddressIfPresent(tree, "NEstdhepvc", NEstdhepvc);
+  SetAddressIfPresent(tree, "NEnvcx", &NEnvcx);
+  SetAddressIfPresent(tree, "NEipvcx", NEipvcx);
+  SetAddressIfPresent(tree, "NEpvcx", NEpvcx);
+  SetAddressIfPresent(tree, "NEiflgvc", NEiflgvc);
+  SetAddressIfPresent(tree, "NEicrnvc", NEicrnvc);
+  SetAddressIfPresent(tree, "NEcrsx", &NEcrsx);
+  SetAddressIfPresent(tree, "NEcrsy", &NEcrsy);
+  SetAddressIfPresent(tree, "NEcrsz", &NEcrsz);
+  SetAddressIfPresent(tree, "NEcrsphi", &NEcrsphi);
+  SetAddressIfPresent(tree, "NEnvert", &NEnvert);
+  SetAddressIfPresent(tree, "NEposvert", NEposvert);
+  SetAddressIfPresent(tree, "NEiflgvert", NEiflgvert);
+  SetAddressIfPresent(tree, "NEnvcvert", &NEnvcvert);
+  SetAddressIfPresent(tree, "NEdirvert", NEdirvert);
+  SetAddressIfPresent(tree, "NEabspvert", NEabspvert);
+  SetAddressIfPresent(tree, "NEabstpvert", NEabstpvert);
+  SetAddressIfPresent(tree, "NEipvert", NEipvert);
+  SetAddressIfPresent(tree, "NEiverti", NEiverti);
+  SetAddressIfPresent(tree, "NEivertf", NEivertf);
+#ifdef HAVE_NUCLEON_FSI_TRACKING
+  SetAddressIfPresent(tree, "NFnvert", &NFnvert);
+  SetAddressIfPresent(tree, "NFiflag", NFiflag);
+  SetAddressIfPresent(tree, "NFx", NFx);
+  SetAddressIfPresent(tree, "NFy", NFy);
+  SetAddressIfPresent(tree, "NFz", NFz);
+  SetAddressIfPresent(tree, "NFpx", NFpx);
+  SetAddressIfPresent(tree, "NFpy", NFpy);
+  SetAddressIfPresent(tree, "NFpz", NFpz);
+  SetAddressIfPresent(tree, "NFe", NFe);
+  SetAddressIfPresent(tree, "NFfirststep", NFfirststep);
+  SetAddressIfPresent(tree, "NFnstep", &NFnstep);
+  SetAddressIfPresent(tree, "NFecms2", NFecms2);
+  SetAddressIfPresent(tree, "NFProb", NFProb);
+#endif
+  SetAddressIfPresent(tree, "GeneratorName", &GeneratorName);
+}
+
+bool NRooTrackerVtx::RebuildVCWork(){
+  bool AllFound = true;
+  for(Int_t partNum = 0; partNum < NEnvc; ++partNum){
+    Int_t StdHepIdx = NEstdhepvc[partNum];
+    NEiorgvc[partNum] = 0;
+    if(StdHepIdx >= 0){
+      if(StdHepIdx >= StdHepN){
+        AllFound = false;
+        continue;
+      }
+      // When emulating NuWro the struck nucleon shares its StdHep entry with
+      // the target nucleus.
+      NEipvc[partNum] = (StdHepPdg[StdHepIdx] > 1000000000) ?
+        StruckNucleonPDG : StdHepPdg[StdHepIdx];
+      for(Int_t i = 0; i < 3; ++i){
+        NEpvc[partNum][i] = StdHepP4[StdHepIdx][i];
+      }
+    } else {
+      Int_t ExtraIdx = -(StdHepIdx+1);
+      if(ExtraIdx >= NEnvcx){
+        AllFound = false;
+        continue;
+      }
+      NEipvc[partNum] = NEipvcx[ExtraIdx];
+      for(Int_t i = 0; i < 3; ++i){
+        NEpvc[partNum][i] = NEpvcx[ExtraIdx][i];
+      }
+    }
+  }
+  return AllFound;
+}
+
+char const* const NRooTrackerVtx::kFSITreeName = "nRooTrackerFSI";
+
+void NRooTrackerVtx::AddFSIBranches(TTree* &tree){
+  std::string NEmaxvertstr = Utils::int2str(kNEmaxvert);
+  std::string NEmaxvertpstr = Utils::int2str(kNEmaxvertp);
+
   tree->Branch("NEnvert", &NEnvert,"NEnvert/I");
   tree->Branch("NEposvert", NEposvert,
     ("NEposvert["+NEmaxvertstr+"][3]/F").c_str());
   tree->Branch("NEiflgvert", NEiflgvert,"NEiflgvert[NEnvert]/I");
-  tree->Branch("NEnvcvert", &NEnvcvert,"NEnvcvert");
+  tree->Branch("NEnvcvert", &NEnvcvert,"NEnvcvert/I");
   tree->Branch("NEdirvert", NEdirvert,
     ("NEdirvert["+NEmaxvertpstr+"][3]/F").c_str());
   tree->Branch("NEabspvert", NEabspvert,"NEabspvert[NEnvcvert]/F");
@@ -237,7 +465,60 @@ void NRooTrackerVtx::AddBranches(TTree* &tree,
   tree->Branch("NFecms2", NFecms2,"NFecms2[NFnstep]/F");
   tree->Branch("NFProb",NFProb,"NFProb[NFnstep]/F");
 #endif
-  tree->Branch("GeneratorName", &GeneratorName);
+}
+
+TTree* NRooTrackerVtx::AttachFSIFriend(TTree* tree, char const* FileName){
+  TTree* FSITree = nullptr;
+  TChain* chain = dynamic_cast<TChain*>(tree);
+  if(chain || FileName){
+    // A chain has no directory, so chain the friend tree over the same files.
+    // Other files are also read through a TChain, which owns the files that
+    // it opens.
+    TChain* FSIChain = new TChain(kFSITreeName);
+    if(FileName){
+      FSIChain->Add(FileName);
+    } else {
+      TObjArray* files = chain->GetListOfFiles();
+      for(Int_t i = 0; i < files->GetEntries(); ++i){
+        // Each TChainElement is titled with its file name.
+        FSIChain->Add(files->At(i)->GetTitle());
+      }
+    }
+    if(FSIChain->GetNtrees()){
+      FSITree = FSIChain;
+    } else {
+      delete FSIChain;
+    }
+  } else if(tree->GetDirectory()){
+    tree->GetDirectory()->GetObject(kFSITreeName, FSITree);
+  }
+
+  if(!FSITree){
+    Warning("NRooTrackerVtx::AttachFSIFriend",
+      "Couldn't find the %s tree in %s.", kFSITreeName,
+      (FileName ? FileName : tree->GetName()));
+    return nullptr;
+  }
+  if(FSITree->GetEntries() != tree->GetEntries()){
+    Warning("NRooTrackerVtx::AttachFSIFriend",
+      "The %s tree has %lld entries, but %s has %lld.", kFSITreeName,
+      FSITree->GetEntries(), tree->GetName(), tree->GetEntries());
+  }
+  tree->AddFriend(FSITree);
+  return FSITree;
+}
+
+Long64_t NRooTrackerVtx::GetEventBufferSize() const {
+  Long64_t size = sizeof(NRooTrackerVtx);
+  size += 6*kNStdHepNPmax*sizeof(Int_t);
+  size += 6*kNEmaxvc*sizeof(Int_t);
+  size += kNEmaxvert*sizeof(Int_t);
+  size += kNEmaxvertp*(2*sizeof(Float_t) + 3*sizeof(Int_t));
+#ifdef HAVE_NUCLEON_FSI_TRACKING
+  size += kNFMaxNucleonVert*(7*sizeof(Float_t) + 2*sizeof(Int_t));
+  size += kNFMaxNucleonSteps*2*sizeof(Float_t);
+#endif
+  return size;
 }
 
 NRooTrackerVtxB::NRooTrackerVtxB(){
@@ -258,6 +539,7 @@ void NRooTrackerVtxB::Reset(){
 
   (*EvtCode) = "";
   EvtNum = 0;
+  FileIndex = 0;
 
   StdHepN = 0;
 
@@ -272,22 +554,176 @@ void NRooTrackerVtxB::Reset(){
 
 void NRooTrackerVtxB::AddBranches(TTree* &tree,
   bool SaveIsBound,
-  bool SaveStruckNucleonPDG){
+  bool SaveStruckNucleonPDG,
+  NRooTrackerSchema const &schema){
 
   std::string NStdHepNPmaxstr = Utils::int2str(kNStdHepNPmax);
 
   tree->Branch("EvtCode", &EvtCode);
   tree->Branch("EvtNum", &EvtNum,"EvtNum/I");
+  if(schema.FileMetadata){
+    tree->Branch("FileIndex", &FileIndex,"FileIndex/I");
+  }
   tree->Branch("StdHepN", &StdHepN,"StdHepN/I");
   tree->Branch("StdHepPdg", StdHepPdg,"StdHepPdg[StdHepN]/I");
   tree->Branch("StdHepStatus", StdHepStatus,"StdHepStatus[StdHepN]/I");
   tree->Branch("StdHepP4", StdHepP4,
-    ("StdHepP4["+NStdHepNPmaxstr+"][4]/D").c_str());
+    ("StdHepP4["+NStdHepNPmaxstr+"][4]/"+
+      schema.P4Precision.LeafType()).c_str());
 
   if(SaveIsBound){ tree->Branch("IsBound", &IsBound, "IsBound/I"); }
   if(SaveStruckNucleonPDG){ tree->Branch("StruckNucleonPDG", &StruckNucleonPDG, "StruckNucleonPDG/I"); }
 
 }
 
+void NRooTrackerVtxB::RoundToPrecision(NRooTrackerSchema const &schema){
+  if(schema.P4Precision.Pol == NRooTrackerPrecision::kDouble){
+    return;
+  }
+  for(Int_t i = 0; i < StdHepN; ++i){
+    for(Int_t j = 0; j < 4; ++j){
+      StdHepP4[i][j] = schema.P4Precision.Round(StdHepP4[i][j]);
+    }
+  }
+}
+
+void NRooTrackerVtxB::SetBranchAddresses(TTree* tree){
+  SetAddressIfPresent(tree, "EvtCode", &EvtCode);
+  SetAddressIfPresent(tree, "EvtNum", &EvtNum);
+  SetAddressIfPresent(tree, "FileIndex", &FileIndex);
+  SetAddressIfPresent(tree, "StdHepN", &StdHepN);
+  SetAddressIfPresent(tree, "StdHepPdg", StdHepPdg);
+  SetAddressIfPresent(tree, "StdHepStatus", StdHepStatus);
+  SetAddressIfPresent(tree, "StdHepP4", StdHepP4);
+  SetAddressIfPresent(tree, "IsBound", &IsBound);
+  SetAddressIfPresent(tree, "StruckNucleonPDG", &StruckNucleonPDG);
+}
+
+Long64_t NRooTrackerVtxB::GetEventBufferSize() const {
+  return sizeof(NRooTrackerVtxB) + 2*kNStdHepNPmax*sizeof(Int_t);
+}
+
+NRooTrackerFileMeta::NRooTrackerFileMeta(){
+  FileName = new TString("");
+  GeneratorName = new TString("NEUT");
+  Reset();
+}
+
+NRooTrackerFileMeta::NRooTrackerFileMeta(NRooTrackerFileMeta const &other){
+  FileName = new TString("");
+  GeneratorName = new TString("NEUT");
+  (*this) = other;
+}
+
+NRooTrackerFileMeta& NRooTrackerFileMeta::operator=(
+  NRooTrackerFileMeta const &other){
+  if(this == &other){ return *this; }
+  FileIndex = other.FileIndex;
+  (*FileName) = (*other.FileName);
+  FirstEntry = other.FirstEntry;
+  NEntriesInFile = other.NEntriesInFile;
+  FirstOutputEntry = other.FirstOutputEntry;
+  NOutputEntries = other.NOutputEntries;
+  EvtWght = other.EvtWght;
+  EvtHistWght = other.EvtHistWght;
+  FluxIntegral = other.FluxIntegral;
+  EvtRateIntegral = other.EvtRateIntegral;
+  (*GeneratorName) = (*other.GeneratorName);
+  NeutVectClassVersion = other.NeutVectClassVersion;
+  return *this;
+}
+
+NRooTrackerFileMeta::~NRooTrackerFileMeta(){
+  if(FileName){ delete FileName; }
+  if(GeneratorName){ delete GeneratorName; }
+}
+
+void NRooTrackerFileMeta::Reset(){
+  FileIndex = 0;
+  (*FileName) = "";
+  FirstEntry = 0;
+  NEntriesInFile = 0;
+  FirstOutputEntry = 0;
+  NOutputEntries = 0;
+  EvtWght = 0;
+  EvtHistWght = 0;
+  FluxIntegral = 0;
+  EvtRateIntegral = 0;
+  (*GeneratorName) = "NEUT";
+  NeutVectClassVersion = 0;
+}
+
+void NRooTrackerFileMeta::AddBranches(TTree* &tree){
+  tree->Branch("FileIndex", &FileIndex, "FileIndex/I");
+  tree->Branch("FileName", &FileName);
+  tree->Branch("FirstEntry", &FirstEntry, "FirstEntry/L");
+  tree->Branch("NEntriesInFile", &NEntriesInFile, "NEntriesInFile/D");
+  tree->Branch("FirstOutputEntry", &FirstOutputEntry, "FirstOutputEntry/L");
+  tree->Branch("NOutputEntries", &NOutputEntries, "NOutputEntries/L");
+  tree->Branch("EvtWght", &EvtWght, "EvtWght/D");
+  tree->Branch("EvtHistWght", &EvtHistWght, "EvtHistWght/D");
+  tree->Branch("FluxIntegral", &FluxIntegral, "FluxIntegral/D");
+  tree->Branch("EvtRateIntegral", &EvtRateIntegral, "EvtRateIntegral/D");
+  tree->Branch("GeneratorName", &GeneratorName);
+  tree->Branch("NeutVectClassVersion", &NeutVectClassVersion,
+    "NeutVectClassVersion/I");
+}
+
+void NRooTrackerFileMeta::SetBranchAddresses(TTree* tree){
+  tree->SetBranchAddress("FileIndex", &FileIndex);
+  tree->SetBranchAddress("FileName", &FileName);
+  tree->SetBranchAddress("FirstEntry", &FirstEntry);
+  tree->SetBranchAddress("NEntriesInFile", &NEntriesInFile);
+  tree->SetBranchAddress("FirstOutputEntry", &FirstOutputEntry);
+  tree->SetBranchAddress("NOutputEntries", &NOutputEntries);
+  tree->SetBranchAddress("EvtWght", &EvtWght);
+  tree->SetBranchAddress("EvtHistWght", &EvtHistWght);
+  tree->SetBranchAddress("FluxIntegral", &FluxIntegral);
+  tree->SetBranchAddress("EvtRateIntegral", &EvtRateIntegral);
+  tree->SetBranchAddress("GeneratorName", &GeneratorName);
+  tree->SetBranchAddress("NeutVectClassVersion", &NeutVectClassVersion);
+}
+
+NRooTrackerMetaReader::NRooTrackerMetaReader(TTree* MetaTree){
+  NRooTrackerFileMeta entry;
+  entry.SetBranchAddresses(MetaTree);
+  for(Long64_t i = 0; i < MetaTree->GetEntries(); ++i){
+    MetaTree->GetEntry(i);
+    if(entry.FileIndex < 0){ continue; }
+    if(size_t(entry.FileIndex) >= fMeta.size()){
+      size_t NKnown = fMeta.size();
+      fMeta.resize(entry.FileIndex+1);
+      // Mark any gaps as unknown
+      for(size_t f = NKnown; f < fMeta.size(); ++f){
+        fMeta[f].FileIndex = -1;
+      }
+    }
+    fMeta[entry.FileIndex] = entry;
+  }
+  MetaTree->ResetBranchAddresses();
+}
+
+Int_t NRooTrackerMetaReader::GetNFiles() const {
+  return fMeta.size();
+}
+
+NRooTrackerFileMeta const* NRooTrackerMetaReader::Get(Int_t FileIndex) const {
+  if((FileIndex < 0) || (size_t(FileIndex) >= fMeta.size()) ||
+     (fMeta[FileIndex].FileIndex != FileIndex)){
+    return nullptr;
+  }
+  return &fMeta[FileIndex];
+}
+
+bool NRooTrackerMetaReader::FillFileConstants(NRooTrackerVtx &vtx) const {
+  NRooTrackerFileMeta const* meta = Get(vtx.FileIndex);
+  if(!meta){ return false; }
+  vtx.EvtWght = meta->EvtWght;
+  vtx.EvtHistWght = meta->EvtHistWght;
+  vtx.NEntriesInFile = meta->NEntriesInFile;
+  (*vtx.GeneratorName) = (*meta->GeneratorName);
+  return true;
+}
+
 ClassImp(NRooTrackerVtxB);
 ClassImp(NRooTrackerVtx);
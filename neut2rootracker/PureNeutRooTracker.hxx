@@ -5,6 +5,9 @@
 #include "TObjString.h"
 #include "TTree.h"
 
+#include <string>
+#include <vector>
+
 const int kNStdHepNPmax = 100;
 const int kNStdHepIdxPx = 0;
 const int kNStdHepIdxPy = 1;
@@ -21,6 +24,82 @@ const int kNEmaxvertp = 300;
 
 extern char const * NEUTStatusCodes[];
 
+///\brief On-disk storage precision for a group of floating point branches.
+///
+///\details Values are always held as \c Double_t in memory. For flat-branch
+/// output the policy selects the leaf type: \c /D for full precision, or a
+/// \c Double32_t (\c /d) leaf, stored either as a float or as an \c NBits
+/// integer spanning <tt>[Min, Max]</tt>. As the streamed layout of the
+/// objects is fixed, for object output the values are instead rounded in
+/// memory to what the equivalent \c Double32_t leaf would read back. For
+/// \c kFloat this leaves the low mantissa bytes zeroed for the compression,
+/// but \c kTruncated values are generally full width doubles, so they are
+/// only quantized and not made any smaller.
+///
+///\note The \c /d leaves need a ROOT version with \c TLeafD32 support.
+struct NRooTrackerPrecision {
+  enum Policy {
+    ///64 bit double.
+    kDouble,
+    ///32 bit float.
+    kFloat,
+    ///\c NBits bit unsigned integer spanning <tt>[Min, Max]</tt>.
+    kTruncated
+  };
+  NRooTrackerPrecision();
+  ///\brief Sets the policy from a string.
+  ///
+  ///\details Accepts \c double, \c float or \c trunc:<min>:<max>:<nbits>,
+  ///where \c nbits is an integer from 2 to 32. Returns false if the string
+  ///could not be parsed.
+  bool Parse(std::string const &spec);
+  ///Returns the leaf list type for this policy, e.g. \c D or \c d[0,10,16].
+  std::string LeafType() const;
+  ///Returns the value that would be read back after storing \c val.
+  Double_t Round(Double_t val) const;
+
+  Policy Pol;
+  Double_t Min;
+  Double_t Max;
+  Int_t NBits;
+};
+
+///Options which change the layout of the output tree.
+struct NRooTrackerSchema {
+  ///Precision of StdHepP4.
+  NRooTrackerPrecision P4Precision;
+  ///Precision of StdHepX4.
+  NRooTrackerPrecision X4Precision;
+  ///Precision of StdHepPolz.
+  NRooTrackerPrecision PolzPrecision;
+  ///\brief Whether to write the per input file constants to the
+  ///nRooTrackerMeta tree rather than to every event.
+  ///
+  ///\details Replaces the EvtWght, EvtHistWght, NEntriesInFile and
+  /// GeneratorName branches with a FileIndex branch and tree aliases that
+  /// read through to the nRooTrackerMeta friend tree.
+  bool FileMetadata;
+  ///\brief Whether to write the compact form of the NEUT VCWork block.
+  ///
+  ///\details The NEipvc, NEpvc and NEiorgvc branches duplicate information
+  /// that is already in the StdHep arrays. In compact form they are replaced
+  /// by the NEstdhepvc index map, and the NEipvcx and NEpvcx arrays for the
+  /// particles which did not make it into the StdHep arrays. The full block
+  /// can be rebuilt with NRooTrackerVtx::RebuildVCWork. Only affects flat
+  /// branch outputs, object outputs always hold the full block.
+  bool CompactVCWork;
+  ///\brief Whether the FSI history is written to the nRooTrackerFSI friend
+  /// tree rather than to the main tree.
+  ///
+  ///\details Removes the NEUT FSIHIST (NE*vert) and nucleon FSI (NF*)
+  /// branches from the main tree, see NRooTrackerVtx::AddFSIBranches and
+  /// NRooTrackerVtx::AttachFSIFriend.
+  bool FSIFriend;
+
+  NRooTrackerSchema()
+      : FileMetadata(false), CompactVCWork(false), FSIFriend(false) {}
+};
+
 ///Most simple NEUT rooTracker-like output format
 class NRooTrackerVtxB : public TObject {
 public:
@@ -32,12 +111,32 @@ public:
   ///tree.
   ///
   ///Additionally can be told to add branches for IsBound and StruckNucleonPDG.
+  ///The leaf types of the floating point branches are chosen by \c schema.
   virtual void AddBranches(TTree* &tree,
-    bool SaveIsBound=false, bool SaveStruckNucleonPDG=false);
+    bool SaveIsBound=false, bool SaveStruckNucleonPDG=false,
+    NRooTrackerSchema const &schema=NRooTrackerSchema());
+  ///\brief Rounds the filled kinematics to the precision given in \c schema.
+  ///
+  ///\details Only needed for object output, flat branches are truncated when
+  ///they are written.
+  virtual void RoundToPrecision(NRooTrackerSchema const &schema);
+  ///Returns the approximate number of bytes held by an instance, including
+  ///the dynamically allocated particle arrays.
+  virtual Long64_t GetEventBufferSize() const;
+  ///\brief Sets branch addresses on a tree written with AddBranches.
+  ///
+  ///\details Branches that do not exist on the tree are skipped.
+  virtual void SetBranchAddresses(TTree* tree);
   ///Generator-specific string with 'event code'.
   TObjString* EvtCode;
   ///Event num.
   Int_t EvtNum;
+  ///\brief Index of the input file that this event was read from.
+  ///
+  ///\details Used to look up the per-file constants in the nRooTrackerMeta
+  /// tree, see NRooTrackerMetaReader. Only written as a flat branch when
+  /// running with per-file metadata.
+  Int_t FileIndex;
   ///Number of particles in the StdHep particle array.
   Int_t StdHepN;
   //******************* stdhep-like particle array
@@ -80,7 +179,7 @@ public:
   ///otherwise this is just a duplciate of StdHepPdg[1].
   Int_t StruckNucleonPDG;
 
-  ClassDef(NRooTrackerVtxB, 1);
+  ClassDef(NRooTrackerVtxB, 2);
 };
 
 ///A subclass of NRooTrackerVtxB that adds additional output information.
@@ -111,8 +210,44 @@ public:
   ///tree.
   ///
   ///Additionally can be told to add branches for IsBound and StruckNucleonPDG.
+  ///The leaf types of the floating point branches are chosen by \c schema.
   void AddBranches(TTree* &tree,
-    bool SaveIsBound=false, bool SaveStruckNucleonPDG=false);
+    bool SaveIsBound=false, bool SaveStruckNucleonPDG=false,
+    NRooTrackerSchema const &schema=NRooTrackerSchema());
+  ///Rounds the filled kinematics to the precision given in \c schema.
+  void RoundToPrecision(NRooTrackerSchema const &schema);
+  ///Returns the approximate number of bytes held by an instance, including
+  ///the dynamically allocated particle and FSI history arrays.
+  Long64_t GetEventBufferSize() const;
+  ///\brief Sets branch addresses on a tree written with AddBranches.
+  ///
+  ///\details Branches that do not exist on the tree are skipped.
+  void SetBranchAddresses(TTree* tree);
+  ///\brief Rebuilds NEipvc, NEpvc and NEiorgvc from the StdHep arrays, for
+  /// events written with a compact VCWork block.
+  ///
+  ///\details Should be called after each GetEntry. Returns false if the
+  /// NEstdhepvc map points outside of the StdHep or NEipvcx arrays.
+  bool RebuildVCWork();
+  ///\brief Adds the FSI history branches, and sets their addresses, on
+  /// \c tree.
+  ///
+  ///\details Used to write the nRooTrackerFSI friend tree, which must be
+  /// filled once for each entry of the main tree.
+  void AddFSIBranches(TTree* &tree);
+  ///\brief Adds the nRooTrackerFSI tree as a friend of \c tree.
+  ///
+  ///\details The friend tree is read from the file that \c tree belongs to
+  /// if \c FileName is \c nullptr. Otherwise the friend is a \c TChain over
+  /// the \c TChain::Add descriptor \c FileName, or, if \c tree is a
+  /// \c TChain, over the same files as \c tree. The caller owns a returned
+  /// \c TChain, which owns the files that it opened. It is entry-aligned
+  /// with \c tree, so after this SetBranchAddresses, GetEntry and
+  /// \c TTree::Draw see the FSI branches as if they were in \c tree. Returns
+  /// the friend tree, or \c nullptr if it could not be found.
+  static TTree* AttachFSIFriend(TTree* tree, char const* FileName=nullptr);
+  ///The name of the FSI history friend tree.
+  static char const* const kFSITreeName;
 
   //****************** Define the output rootracker tree branches
 
@@ -181,6 +316,23 @@ public:
   /// Escaped nucleus (1) or not (0)
   Int_t* NEicrnvc; //[NEnvc]
 
+  ///\brief Compact VCWork: where each NEUT particle was saved.
+  ///\details Values:
+  /// * >= 0 : The StdHep index of this particle.
+  /// * < 0  : Not saved to StdHep (see the \c -S CLI option), the PDG and
+  /// *        momentum are at index <tt>-(NEstdhepvc+1)</tt> of NEipvcx and
+  /// *        NEpvcx.
+  ///
+  /// The compact VCWork members are only written as flat branches, so they
+  /// are not streamed with the object.
+  Int_t* NEstdhepvc; //!
+  /// Compact VCWork: Number of particles not saved to StdHep
+  Int_t NEnvcx; //!
+  /// Compact VCWork: PDG code of the particles not saved to StdHep
+  Int_t* NEipvcx; //!
+  /// Compact VCWork: 3-momentum of the particles not saved to StdHep
+  Float_t NEpvcx[kNEmaxvc][3]; //!
+
 
   //******** Rest of the NEUT variables below are mainly for internal
   //********************** reweighting routines
@@ -304,6 +456,78 @@ public:
   ///The name of the generator, in this case always NEUT.
   TString* GeneratorName;
 
-  ClassDef(NRooTrackerVtx, 1);
+  ClassDef(NRooTrackerVtx, 2);
+};
+
+///\brief Constants for a single input file, as written to the nRooTrackerMeta
+///tree.
+///
+///\details One entry is written per input file when running with per-file
+/// metadata. Events refer to their entry through NRooTrackerVtxB::FileIndex.
+/// Only ever written as flat branches, so it has no dictionary.
+class NRooTrackerFileMeta {
+public:
+  NRooTrackerFileMeta();
+  NRooTrackerFileMeta(NRooTrackerFileMeta const &other);
+  NRooTrackerFileMeta& operator=(NRooTrackerFileMeta const &other);
+  ~NRooTrackerFileMeta();
+  ///Resets all data members to default values.
+  void Reset();
+  ///Adds data member branches and sets branch addresses on passed tree.
+  void AddBranches(TTree* &tree);
+  ///Sets branch addresses on a tree written with AddBranches.
+  void SetBranchAddresses(TTree* tree);
+
+  ///Index of this file in the input TChain.
+  Int_t FileIndex;
+  ///The name of the input file.
+  TString* FileName;
+  ///The first TChain entry that was read from this file.
+  Long64_t FirstEntry;
+  ///The number of entries in this file.
+  Double_t NEntriesInFile;
+  ///The first output entry that was converted from this file.
+  Long64_t FirstOutputEntry;
+  ///The number of output entries that were converted from this file.
+  Long64_t NOutputEntries;
+  ///See NRooTrackerVtx::EvtWght.
+  Double_t EvtWght;
+  ///See NRooTrackerVtx::EvtHistWght.
+  Double_t EvtHistWght;
+  ///Integral of the \c flux_numu histogram in this file, 0 if missing.
+  Double_t FluxIntegral;
+  ///Integral of the \c evtrt_numu histogram in this file, 0 if missing.
+  Double_t EvtRateIntegral;
+  ///The name of the generator, in this case always NEUT.
+  TString* GeneratorName;
+  ///The ROOT class version of the NeutVect used to read this file. This is
+  ///not the NEUT release version.
+  Int_t NeutVectClassVersion;
+};
+
+///\brief Reader helper for files written with per-file metadata.
+///
+///\details Reads the whole nRooTrackerMeta tree up front so that the
+/// per-event values can be recovered for each event. For compiled code only,
+/// it has no dictionary.
+///
+///\note For \c TTree::Draw style access the flat nRooTracker tree carries
+/// aliases for EvtWght, EvtHistWght, NEntriesInFile and GeneratorName.
+class NRooTrackerMetaReader {
+public:
+  ///Reads all entries from \c MetaTree.
+  NRooTrackerMetaReader(TTree* MetaTree);
+  ///Returns the number of input files described.
+  Int_t GetNFiles() const;
+  ///Returns the metadata for \c FileIndex, or nullptr if it is unknown.
+  NRooTrackerFileMeta const* Get(Int_t FileIndex) const;
+  ///\brief Fills the per-file members of \c vtx from the entry for
+  /// vtx.FileIndex.
+  ///
+  ///\details Returns false if the file index is unknown.
+  bool FillFileConstants(NRooTrackerVtx &vtx) const;
+
+private:
+  std::vector<NRooTrackerFileMeta> fMeta;
 };
 #endif
@@ -0,0 +1,251 @@
+#include <cmath>
+#include <cstdlib>
+#include <map>
+
+#include "LUtils/Debugging.hxx"
+#include "LUtils/Utils.hxx"
+
+#include "TopologySkim.hxx"
+
+namespace {
+
+std::map<std::string, std::vector<int> > const& GetSpecies() {
+  static std::map<std::string, std::vector<int> > species;
+  if (species.empty()) {
+    species["l"] = {11, -11, 13, -13, 15, -15};
+    species["l-"] = {11, 13, 15};
+    species["l+"] = {-11, -13, -15};
+    species["e"] = {11, -11};
+    species["e-"] = {11};
+    species["e+"] = {-11};
+    species["mu"] = {13, -13};
+    species["mu-"] = {13};
+    species["mu+"] = {-13};
+    species["nu"] = {12, -12, 14, -14, 16, -16};
+    species["pi"] = {211, -211, 111};
+    species["pic"] = {211, -211};
+    species["pi+"] = {211};
+    species["pi-"] = {-211};
+    species["pi0"] = {111};
+    species["p"] = {2212};
+    species["n"] = {2112};
+    species["gamma"] = {22};
+  }
+  return species;
+}
+
+std::map<std::string, std::string> const& GetNamedTopologies() {
+  static std::map<std::string, std::string> topologies;
+  if (topologies.empty()) {
+    topologies["CC"] = "l>=1";
+    topologies["NC"] = "l==0";
+    topologies["CC0pi"] = "l>=1&pi==0";
+    topologies["CC1pip"] = "l>=1&pi+==1&pi-==0&pi0==0";
+    topologies["CC1pim"] = "l>=1&pi-==1&pi+==0&pi0==0";
+    topologies["CC1pi0"] = "l>=1&pi0==1&pic==0";
+    topologies["NC0pi"] = "l==0&pi==0";
+    topologies["NC1pi0"] = "l==0&pi0==1&pic==0";
+  }
+  return topologies;
+}
+
+bool ParseTerm(std::string const& spec, TopologySkim::Term& term) {
+  size_t OpStart = spec.find_first_of("=!<>");
+  if ((OpStart == std::string::npos) || (OpStart == 0)) {
+    return false;
+  }
+  size_t OpEnd = spec.find_first_not_of("=!<>", OpStart);
+  if (OpEnd == std::string::npos) {
+    return false;
+  }
+
+  std::string Particle = spec.substr(0, OpStart);
+  std::string Op = spec.substr(OpStart, OpEnd - OpStart);
+  std::string Count = spec.substr(OpEnd);
+
+  term.MinMomentum = 0;
+  term.EUnitScaleFactor = 1;
+  size_t At = Particle.find('@');
+  if (At != std::string::npos) {
+    std::string MomStr = Particle.substr(At + 1);
+    char* end = nullptr;
+    term.MinMomentum = strtod(MomStr.c_str(), &end);
+    if (MomStr.empty() || (*end != '\0')) {
+      return false;
+    }
+    Particle = Particle.substr(0, At);
+  }
+
+  std::map<std::string, std::vector<int> >::const_iterator sp =
+      GetSpecies().find(Particle);
+  if (sp != GetSpecies().end()) {
+    term.PDGs = sp->second;
+  } else {
+    int pdg;
+    if (Utils::str2int(pdg, Particle.c_str()) != Utils::STRINT_SUCCESS) {
+      return false;
+    }
+    term.PDGs = {pdg};
+  }
+
+  if ((Op == "==") || (Op == "=")) {
+    term.Comp = TopologySkim::Term::kEq;
+  } else if (Op == "!=") {
+    term.Comp = TopologySkim::Term::kNe;
+  } else if (Op == ">=") {
+    term.Comp = TopologySkim::Term::kGe;
+  } else if (Op == "<=") {
+    term.Comp = TopologySkim::Term::kLe;
+  } else if (Op == ">") {
+    term.Comp = TopologySkim::Term::kGt;
+  } else if (Op == "<") {
+    term.Comp = TopologySkim::Term::kLt;
+  } else {
+    return false;
+  }
+
+  return (Utils::str2int(term.N, Count.c_str()) == Utils::STRINT_SUCCESS);
+}
+}
+
+namespace TopologySkim {
+
+bool Term::Pass(NRooTrackerVtxB const& ev) const {
+  int Found = 0;
+  for (int i = 0; i < ev.StdHepN; ++i) {
+    if (ev.StdHepStatus[i] != 1) {
+      continue;
+    }
+    bool Matched = false;
+    for (int const& pdg : PDGs) {
+      if (ev.StdHepPdg[i] == pdg) {
+        Matched = true;
+        break;
+      }
+    }
+    if (!Matched) {
+      continue;
+    }
+    if (MinMomentum > 0) {
+      double Mom = std::sqrt(ev.StdHepP4[i][kNStdHepIdxPx] *
+                                 ev.StdHepP4[i][kNStdHepIdxPx] +
+                             ev.StdHepP4[i][kNStdHepIdxPy] *
+                                 ev.StdHepP4[i][kNStdHepIdxPy] +
+                             ev.StdHepP4[i][kNStdHepIdxPz] *
+                                 ev.StdHepP4[i][kNStdHepIdxPz]);
+      if (Mom < (MinMomentum * EUnitScaleFactor)) {
+        continue;
+      }
+    }
+    Found++;
+  }
+
+  switch (Comp) {
+    case kEq: {
+      return Found == N;
+    }
+    case kNe: {
+      return Found != N;
+    }
+    case kGe: {
+      return Found >= N;
+    }
+    case kLe: {
+      return Found <= N;
+    }
+    case kGt: {
+      return Found > N;
+    }
+    case kLt: {
+      return Found < N;
+    }
+  }
+  return false;
+}
+
+bool Predicate::Parse(std::string const& spec) {
+  fName = spec;
+  fTerms.clear();
+  for (std::string const& tok : Utils::SplitStringByDelim(spec, "&")) {
+    std::map<std::string, std::string>::const_iterator named =
+        GetNamedTopologies().find(tok);
+    std::vector<std::string> TermSpecs;
+    if (named != GetNamedTopologies().end()) {
+      TermSpecs = Utils::SplitStringByDelim(named->second, "&");
+    } else {
+      TermSpecs.push_back(tok);
+    }
+
+    for (std::string const& TermSpec : TermSpecs) {
+      Term term;
+      if (!ParseTerm(TermSpec, term)) {
+        UDBError("Failed to parse skim term: \"" << TermSpec
+                                                 << "\" in predicate: \""
+                                                 << spec << "\"");
+        return false;
+      }
+      fTerms.push_back(term);
+    }
+  }
+  return !fTerms.empty();
+}
+
+void Predicate::SetEUnitScaleFactor(double EUnitScaleFactor) {
+  for (Term& term : fTerms) {
+    term.EUnitScaleFactor = EUnitScaleFactor;
+  }
+}
+
+bool Predicate::Pass(NRooTrackerVtxB const& ev) const {
+  for (Term const& term : fTerms) {
+    if (!term.Pass(ev)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Skim::Skim() : fNEvaluated(0), fNKept(0) {}
+
+bool Skim::Parse(std::string const& spec) {
+  for (std::string const& predspec : Utils::SplitStringByDelim(spec, ",")) {
+    Predicate pred;
+    if (!pred.Parse(predspec)) {
+      return false;
+    }
+    fPredicates.push_back(pred);
+    fNPassed.push_back(0);
+  }
+  return IsActive();
+}
+
+void Skim::SetEUnitScaleFactor(double EUnitScaleFactor) {
+  for (Predicate& pred : fPredicates) {
+    pred.SetEUnitScaleFactor(EUnitScaleFactor);
+  }
+}
+
+bool Skim::Pass(NRooTrackerVtxB const& ev) {
+  bool Keep = false;
+  for (size_t p = 0; p < fPredicates.size(); ++p) {
+    if (fPredicates[p].Pass(ev)) {
+      fNPassed[p]++;
+      Keep = true;
+    }
+  }
+  fNEvaluated++;
+  if (Keep) {
+    fNKept++;
+  }
+  return Keep;
+}
+
+void Skim::Report(std::string const& SinkName) const {
+  UDBLog("Topology skim for " << SinkName << ": kept " << fNKept << "/"
+                              << fNEvaluated << " events.");
+  for (size_t p = 0; p < fPredicates.size(); ++p) {
+    UDBLog("\t" << fPredicates[p].GetName() << ": passed " << fNPassed[p]
+                << ", failed " << (fNEvaluated - fNPassed[p]));
+  }
+}
+}
@@ -0,0 +1,91 @@
+#ifndef TOPOLOGYSKIM_HXX_SEEN
+#define TOPOLOGYSKIM_HXX_SEEN
+#include <string>
+#include <vector>
+
+#include "PureNeutRooTracker.hxx"
+
+///\brief Final state topology selections, evaluated on the converted StdHep
+/// arrays just before an event is written.
+///
+///\details A predicate is a list of terms separated by \c &, all of which must
+/// pass. Each term counts the final state (<tt>StdHepStatus == 1</tt>)
+/// particles of a species and compares the count to a number, like
+/// <tt>pi+==1</tt>. A minimum momentum can be given for the counted particles
+/// with \c @, like <tt>p@500>=1</tt>, in MeV whatever the output units.
+///
+/// Species are \c l, \c l-, \c l+ (charged leptons), \c e, \c e-, \c e+,
+/// \c mu, \c mu-, \c mu+, \c nu, \c pi, \c pic (charged pions), \c pi+,
+/// \c pi-, \c pi0, \c p, \c n, \c gamma or a PDG code. The comparisons are
+/// \c ==, \c !=, \c >=, \c <=, \c > and \c <.
+///
+/// The named topologies \c CC, \c NC, \c CC0pi, \c CC1pip, \c CC1pim,
+/// \c CC1pi0, \c NC0pi and \c NC1pi0 can be used as terms, for example
+/// <tt>CC0pi&p@500>=1</tt>.
+namespace TopologySkim {
+
+///A requirement on the number of final state particles of some species.
+struct Term {
+  enum Comparison { kEq, kNe, kGe, kLe, kGt, kLt };
+  ///Any of these PDG codes are counted.
+  std::vector<int> PDGs;
+  ///Minimum 3-momentum magnitude of counted particles in MeV.
+  double MinMomentum;
+  ///Converts MeV to the units of the StdHep arrays, see
+  ///Skim::SetEUnitScaleFactor.
+  double EUnitScaleFactor;
+  Comparison Comp;
+  int N;
+
+  bool Pass(NRooTrackerVtxB const& ev) const;
+};
+
+///All of a list of terms, parsed from a single predicate specification.
+class Predicate {
+public:
+  ///\brief Parses \c spec.
+  ///
+  ///\details Returns false and writes an error if it could not be parsed.
+  bool Parse(std::string const& spec);
+  ///See Skim::SetEUnitScaleFactor.
+  void SetEUnitScaleFactor(double EUnitScaleFactor);
+  bool Pass(NRooTrackerVtxB const& ev) const;
+  std::string const& GetName() const { return fName; }
+
+private:
+  std::string fName;
+  std::vector<Term> fTerms;
+};
+
+///\brief A set of predicates, an event is kept if any of them pass.
+///
+///\details Every predicate is evaluated for every event so that the
+/// per-predicate pass counts are independent.
+class Skim {
+public:
+  Skim();
+  ///\brief Parses a comma separated list of predicates.
+  ///
+  ///\details Returns false if any of them could not be parsed.
+  bool Parse(std::string const& spec);
+  ///Whether any predicates have been added.
+  bool IsActive() const { return !fPredicates.empty(); }
+  ///\brief Sets the factor from MeV to the units of the events passed to
+  /// Pass, e.g. 1E-3 for GeV outputs.
+  ///
+  ///\details Momentum thresholds are always given in MeV, so that the same
+  /// predicate selects the same events from outputs in different units.
+  void SetEUnitScaleFactor(double EUnitScaleFactor);
+  ///Evaluates all predicates on \c ev and updates the counts.
+  bool Pass(NRooTrackerVtxB const& ev);
+  ///Writes the pass/fail counts for each predicate to the log.
+  void Report(std::string const& SinkName) const;
+
+private:
+  std::vector<Predicate> fPredicates;
+  std::vector<long> fNPassed;
+  long fNEvaluated;
+  long fNKept;
+};
+}
+#endif
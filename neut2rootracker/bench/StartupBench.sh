@@ -0,0 +1,63 @@
+#!/bin/bash
+# Compares the start up cost of the full and headless NeutToRooTracker builds.
+#
+# Each executable converts a single event from the input file, NRUNS times,
+# and the median wall time, time to first event and peak RSS are reported,
+# along with the number of shared libraries that each executable loads.
+#
+# The time to first event is the wall clock time that the converter logs at
+# its first event (with -t) minus the time that it was launched, so it includes the
+# dynamic loading and static initialisation of the linked libraries.
+#
+# Usage: StartupBench.sh <input neutroot file> [NRUNS=10] [BINDIR=../bin]
+
+if [ -z "${1}" ]; then
+  echo "Usage: ${0} <input neutroot file> [NRUNS=10] [BINDIR=../bin]"
+  exit 1
+fi
+
+INPUT=${1}
+NRUNS=${2:-10}
+BINDIR=${3:-$(dirname ${0})/../bin}
+
+if [ ! -e /usr/bin/time ]; then
+  echo "[ERROR]: /usr/bin/time is required to measure the peak RSS."
+  exit 1
+fi
+
+TMPDIR=$(mktemp -d)
+trap "rm -rf ${TMPDIR}" EXIT
+
+median() {
+  sort -g | awk '{ v[NR] = $1 } END { if (NR % 2) { print v[(NR + 1) / 2] } else { print (v[NR / 2] + v[NR / 2 + 1]) / 2 } }'
+}
+
+printf "%-34s %6s %10s %14s %13s\n" "Executable" "Libs" "Wall (s)" "1st event (s)" "Peak RSS (MB)"
+for EXE in NeutToRooTracker.exe NeutToRooTracker_headless.exe; do
+  if [ ! -x ${BINDIR}/${EXE} ]; then
+    echo "[WARN]: ${BINDIR}/${EXE} not found, build it with make or make headless."
+    continue
+  fi
+
+  NLIBS=$(ldd ${BINDIR}/${EXE} | wc -l)
+
+  # Warm the page cache so that the first run is not an outlier.
+  ${BINDIR}/${EXE} -i ${INPUT} -n 1 -o ${TMPDIR}/out.root &> /dev/null
+
+  rm -f ${TMPDIR}/wall ${TMPDIR}/first ${TMPDIR}/rss
+  for i in $(seq ${NRUNS}); do
+    LAUNCH=$(date +%s.%N)
+    /usr/bin/time -f "%e %M" -o ${TMPDIR}/time \
+      ${BINDIR}/${EXE} -i ${INPUT} -n 1 -o ${TMPDIR}/out.root -t \
+      &> ${TMPDIR}/log
+    awk '{ print $1 }' ${TMPDIR}/time >> ${TMPDIR}/wall
+    awk '{ print $2 / 1024 }' ${TMPDIR}/time >> ${TMPDIR}/rss
+    sed -n "s/.*Time to first event:.*wall clock: \([0-9.]*\) s.*/\1/p" \
+      ${TMPDIR}/log | awk -v launch=${LAUNCH} '{ print $1 - launch }' \
+      >> ${TMPDIR}/first
+  done
+
+  printf "%-34s %6s %10s %14s %13s\n" ${EXE} ${NLIBS} \
+    $(median < ${TMPDIR}/wall) $(median < ${TMPDIR}/first) \
+    $(median < ${TMPDIR}/rss)
+done